@@ -1,14 +1,19 @@
 #include "ofApp.h"
+#include "core/DspMetrics.h"
 
 void ofApp::setup() {
     ofSetVerticalSync(true);
     ofSetFrameRate(60);
     
+    // Output history for the scope, before the stream can call audioOut()
+    scope.reset(new ScopeBuffer(44100, 10.0));
+    scopeSeconds = 0.05f;
+    
     // Setup audio
     ofSoundStreamSettings settings;
     settings.setOutListener(this);
     settings.sampleRate = 44100;
-    settings.numOutputChannels = 1;
+    settings.numOutputChannels = 2;
     settings.numInputChannels = 0;
     settings.bufferSize = 512;
     soundStream.setup(settings);
@@ -27,7 +32,6 @@ void ofApp::setup() {
     isPlaying = true;
     
     // Initialize visualization buffers
-    waveform.resize(512);
     tractShape.resize(44);
     noseShape.resize(28);
     
@@ -73,17 +77,9 @@ void ofApp::draw() {
     ofDrawBitmapString("Mouse: Control tongue position", 20, 40);
     ofDrawBitmapString("Keys: A,E,I,O,U - vowels, Space - silence", 20, 60);
     ofDrawBitmapString("Up/Down arrows: pitch, Left/Right: tenseness", 20, 80);
+    ofDrawBitmapString("+/-: scope zoom (" + ofToString(scopeSeconds * 1000.0f, 0) + " ms)", 20, 100);
     
-    // Draw waveform
-    ofSetColor(100, 200, 255);
-    ofNoFill();
-    ofBeginShape();
-    for (int i = 0; i < waveform.size(); i++) {
-        float x = ofMap(i, 0, waveform.size(), 50, ofGetWidth() - 50);
-        float y = ofGetHeight() / 2 + waveform[i] * 100;
-        ofVertex(x, y);
-    }
-    ofEndShape();
+    drawScope(50, ofGetHeight() / 2, ofGetWidth() - 100, 100);
     
     // Draw vocal tract with better visualization
     ofSetColor(255, 100, 100);
@@ -145,6 +141,90 @@ void ofApp::draw() {
         tractDebug += ofToString(tractShape[i], 1) + " ";
     }
     ofDrawBitmapString(tractDebug, 20, 120);
+    
+    drawMetrics(ofGetWidth() - 270, 20);
+    drawFormants(ofGetWidth() - 270, 140);
+}
+
+// Envelope of the output over the last scopeSeconds, one column per pixel
+void ofApp::drawScope(float x, float y, float width, float height) {
+    int numColumns = max(1, (int)width);
+    scopeColumns.resize(numColumns);
+    scope->read(scopeColumns.data(), numColumns, scopeSeconds);
+    
+    ofSetColor(100, 200, 255);
+    ofFill();
+    ofBeginShape();
+    for (int i = 0; i < numColumns; i++) {
+        const t_scopeColumn& column = scopeColumns[i];
+        ofVertex(x + i, y + (column.min <= column.max ? column.max : 0.0f) * height);
+    }
+    for (int i = numColumns - 1; i >= 0; i--) {
+        const t_scopeColumn& column = scopeColumns[i];
+        // At least a pixel thick, so quiet stretches still show
+        ofVertex(x + i, y + (column.min <= column.max ? column.min : 0.0f) * height - 1);
+    }
+    ofEndShape();
+}
+
+void ofApp::drawMetrics(float x, float y) {
+    const DspMetrics* metrics = voice.getMetrics();
+    if (!metrics) return;
+    
+    ofSetColor(255);
+    ofDrawBitmapString("Render: " + ofToString(metrics->getRenderTime(), 1) + " us", x, y);
+    ofDrawBitmapString("Load: " + ofToString(metrics->getLoad(), 1) + " %", x, y + 15);
+    ofDrawBitmapString("p50/p99/max: " + ofToString(metrics->getLoadPercentile(50), 0) + " / "
+                       + ofToString(metrics->getLoadPercentile(99), 0) + " / "
+                       + ofToString(metrics->getLoadPercentile(100), 0) + " %", x, y + 30);
+    ofDrawBitmapString("Xrun risk: " + ofToString(metrics->getXrunRiskCount()), x, y + 45);
+    
+    // Load histogram, one column per percent up to 100%
+    uint32_t bins[METRICS_HISTOGRAM_BINS];
+    metrics->getHistogram(bins);
+    uint32_t maxCount = 1;
+    for (int i = 0; i < METRICS_HISTOGRAM_BINS; i++) maxCount = max(maxCount, bins[i]);
+    
+    float top = y + 55, height = 40;
+    ofSetColor(60);
+    ofNoFill();
+    ofDrawRectangle(x, top, 2 * 101, height);
+    ofFill();
+    for (int i = 0; i < METRICS_HISTOGRAM_BINS; i++) {
+        if (bins[i] == 0) continue;
+        int column = min(i, 100);
+        float h = height * bins[i] / (float)maxCount;
+        if (i >= METRICS_XRUN_RISK_LOAD) ofSetColor(255, 80, 80);
+        else ofSetColor(100, 255, 100);
+        ofDrawRectangle(x + 2 * column, top + height - h, 2, h);
+    }
+}
+
+void ofApp::drawFormants(float x, float y) {
+    const FormantAnalyzer* formants = voice.getFormants();
+    if (!formants) return;
+    
+    ofSetColor(255);
+    for (int i = 0; i < formants->getFormantCount(); i++) {
+        const t_formant& formant = formants->getFormant(i);
+        ofDrawBitmapString("F" + ofToString(i + 1) + ": " + ofToString(formant.frequency, 0)
+                           + " Hz, bw " + ofToString(formant.bandwidth, 0) + " Hz", x, y + 15 * i);
+    }
+    
+    // Response in dB, 60 dB range
+    const vector<float>& response = formants->getResponse();
+    float top = y + 15 * NUM_FORMANTS, height = 40, width = 202;
+    float peak = *max_element(response.begin(), response.end());
+    ofSetColor(60);
+    ofNoFill();
+    ofDrawRectangle(x, top, width, height);
+    ofSetColor(255, 180, 100);
+    ofBeginShape();
+    for (size_t i = 0; i < response.size(); i++) {
+        float level = ofClamp((response[i] - peak + 60.0f) / 60.0f, 0.0f, 1.0f);
+        ofVertex(x + width * i / (float)(response.size() - 1), top + height * (1.0f - level));
+    }
+    ofEndShape();
 }
 
 void ofApp::keyPressed(int key) {
@@ -191,20 +271,22 @@ void ofApp::keyPressed(int key) {
             tenseness = ofClamp(tenseness - 0.1f, 0.0f, 1.0f);
             voice.setTenseness(tenseness);
             break;
+        case '+': case '=':
+            scopeSeconds = max(scopeSeconds * 0.5f, 0.005f);
+            break;
+        case '-':
+            scopeSeconds = min(scopeSeconds * 2.0f, 10.0f);
+            break;
     }
 }
 
 void ofApp::audioOut(ofSoundBuffer& output) {
     if (isPlaying) {
-        voice.synthesize(output.getBuffer().data(), output.getNumFrames());
-        int numSamples = min((int)waveform.size(), (int)output.getNumFrames());
-        for (int i = 0; i < numSamples; i++) {
-            waveform[i] = output[i];
-        }
+        voice.synthesize(output);
     } else {
         output.set(0.0f);
-        fill(waveform.begin(), waveform.end(), 0.0f);
     }
+    scope->write(output.getBuffer().data(), output.getNumFrames(), output.getNumChannels());
 }
 
 void ofApp::mouseMoved(int x, int y) {
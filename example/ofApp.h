@@ -2,6 +2,7 @@
 
 #include "ofMain.h"
 #include "ofxPinkTrombone.h"
+#include "core/ScopeBuffer.h"
 
 class ofApp : public ofBaseApp {
 public:
@@ -15,11 +16,17 @@ public:
     
     void audioOut(ofSoundBuffer& output);
     
+    void drawScope(float x, float y, float width, float height);
+    void drawMetrics(float x, float y);
+    void drawFormants(float x, float y);
+    
     ofxPinkTrombone voice;
     ofSoundStream soundStream;
     
     // Visualization
-    vector<float> waveform;
+    unique_ptr<ScopeBuffer> scope;      // written by audioOut()
+    vector<t_scopeColumn> scopeColumns;
+    float scopeSeconds;
     vector<float> tractShape;
     vector<float> noseShape;
     
@@ -0,0 +1,115 @@
+//==============================================================================
+// src/BatchRenderer.cpp
+//==============================================================================
+
+#include "BatchRenderer.h"
+#include <chrono>
+#include <thread>
+
+// Frames per synthesize() call, so counters advance while long utterances render
+static const int renderChunk = 16384;
+
+static double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+BatchRenderer::BatchRenderer(int tractLength, t_tractPrecision precision)
+    : tractLength(tractLength)
+    , precision(precision)
+    , threadCount(0)
+    , tailSeconds(0.5)
+    , seed(0)
+    , mathQuality(PINK_TROMBONE_MATH_QUALITY)
+    , progressInterval(1.0)
+    , nextUtterance(0), completed(0), framesRendered(0)
+    , cancelled(false)
+    , total(0)
+    , sampleRate(0)
+    , startTime(0) {
+}
+
+void BatchRenderer::setProgressCallback(std::function<void(const t_batchProgress&)> callback, double interval) {
+    progressCallback = callback;
+    progressInterval = std::max(0.01, interval);
+}
+
+bool BatchRenderer::render(const Score& score, const std::string& path) {
+    if (!score.isLoaded()) return false;
+    if (score.getLength() > (uint64_t) RENDER_MAX_SECONDS * score.getSampleRate()) return false;
+
+    sampleRate = score.getSampleRate();
+    total = score.getVoiceCount();
+    uint64_t tail = (uint64_t) (std::min(std::max(0.0, tailSeconds), (double) RENDER_MAX_SECONDS) * sampleRate);
+    std::vector<uint64_t> frameCounts(total);
+    for (uint64_t i = 0; i < total; i++) {
+        uint64_t count = score.getKeyframeCount((int) i);
+        frameCounts[i] = (count > 0 ? score.getKeyframes((int) i)[count - 1].sampleTime : 0) + tail;
+    }
+
+    RenderArchive archive;
+    if (!archive.create(path, sampleRate, 1, frameCounts)) return false;
+
+    nextUtterance = 0;
+    completed = 0;
+    framesRendered = 0;
+    cancelled = false;
+    startTime = now();
+
+    int threads = threadCount > 0 ? threadCount : (int) std::thread::hardware_concurrency();
+    threads = (int) std::min<uint64_t>(std::max(1, threads), std::max<uint64_t>(1, total));
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++) {
+        workers.emplace_back(&BatchRenderer::work, this, std::cref(score), std::ref(archive));
+    }
+
+    double nextReport = startTime + progressInterval;
+    while (completed.load() < total && !cancelled) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (progressCallback && now() >= nextReport) {
+            progressCallback(getProgress());
+            nextReport += progressInterval;
+        }
+    }
+    for (auto& worker : workers) worker.join();
+
+    if (progressCallback) progressCallback(getProgress());
+    bool finished = !cancelled && archive.flush();
+    archive.close();
+    return finished;
+}
+
+void BatchRenderer::work(const Score& score, RenderArchive& archive) {
+    PinkTrombone voice((float) sampleRate, tractLength, precision);
+    voice.setMathQuality(mathQuality);
+    VoiceState fresh;
+    voice.saveState(fresh);
+
+    uint64_t i;
+    while (!cancelled && (i = nextUtterance++) < total) {
+        voice.restoreState(fresh);
+        voice.setSeed(seed + (uint32_t) i);
+        ScoreSequencer sequencer(score, (int) i);
+
+        float* output = archive.getWritableSamples(i);
+        uint64_t frames = archive.getFrameCount(i);
+        for (uint64_t done = 0; done < frames && !cancelled; ) {
+            int chunk = (int) std::min<uint64_t>(renderChunk, frames - done);
+            sequencer.render(voice, output + done, chunk);
+            done += chunk;
+            framesRendered += chunk;
+        }
+        if (!cancelled) completed++;
+    }
+}
+
+t_batchProgress BatchRenderer::getProgress() const {
+    t_batchProgress progress;
+    progress.completed = completed.load();
+    progress.total = total;
+    progress.framesRendered = framesRendered.load();
+    progress.elapsed = startTime > 0 ? now() - startTime : 0;
+    double elapsed = std::max(progress.elapsed, 1e-9);
+    progress.utterancesPerSecond = progress.completed / elapsed;
+    progress.realtimeFactor = sampleRate > 0 ? progress.framesRendered / (double) sampleRate / elapsed : 0;
+    return progress;
+}
@@ -0,0 +1,67 @@
+//==============================================================================
+// src/BatchRenderer.h - Offline rendering of many scores across all cores
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include "PinkTrombone.h"
+#include "ScoreSequencer.h"
+#include "core/RenderArchive.h"
+
+typedef struct t_batchProgress {
+    uint64_t completed;             // utterances
+    uint64_t total;
+    uint64_t framesRendered;
+    double elapsed;                 // seconds since render() started
+    double utterancesPerSecond;
+    double realtimeFactor;          // seconds of audio per second of rendering
+} t_batchProgress;
+
+// Renders every voice of a Score as a separate mono utterance into a
+// RenderArchive, which is created at its final size up front. Utterances are
+// handed out one at a time to worker threads, each with its own PinkTrombone
+// that is reset to a fresh state and reseeded (seed + utterance index) before
+// every utterance, so the output is the same whatever the thread count.
+// An utterance lasts until its last keyframe plus the tail; scores with
+// keyframes past RENDER_MAX_SECONDS are refused.
+class BatchRenderer {
+public:
+    BatchRenderer(int tractLength = 44, t_tractPrecision precision = TRACT_PRECISION_FLOAT);
+
+    void setThreadCount(int threads) { threadCount = threads; }    // 0 uses every core
+    void setTail(double seconds) { tailSeconds = seconds; }        // 0.5 by default
+    void setSeed(uint32_t seed) { this->seed = seed; }
+    void setMathQuality(t_mathQuality quality) { mathQuality = quality; }
+    // Called on the thread running render(), every interval seconds and once
+    // at the end
+    void setProgressCallback(std::function<void(const t_batchProgress&)> callback,
+                             double interval = 1.0);
+
+    // Blocks until every utterance is rendered and flushed, or cancel() is
+    // called. Returns false if the archive could not be created or the
+    // render was cancelled.
+    bool render(const Score& score, const std::string& path);
+    // Safe to call from any thread, including the progress callback
+    void cancel() { cancelled = true; }
+    t_batchProgress getProgress() const;
+
+private:
+    void work(const Score& score, RenderArchive& archive);
+
+    int tractLength;
+    t_tractPrecision precision;
+    int threadCount;
+    double tailSeconds;
+    uint32_t seed;
+    t_mathQuality mathQuality;
+    std::function<void(const t_batchProgress&)> progressCallback;
+    double progressInterval;
+
+    std::atomic<uint64_t> nextUtterance, completed, framesRendered;
+    std::atomic<bool> cancelled;
+    uint64_t total;
+    int sampleRate;
+    double startTime;
+};
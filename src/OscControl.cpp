@@ -0,0 +1,293 @@
+//==============================================================================
+// src/OscControl.cpp
+//==============================================================================
+
+#include "OscControl.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// Weight of each block's timing error in the sample clock mapping
+#define CLOCK_SMOOTHING     (0.01)
+// Errors beyond this, e.g. after the stream stalled, restart the mapping
+#define CLOCK_RESET         (0.25)      // seconds
+// Receiver wakes this often to notice stop()
+#define RECEIVE_TIMEOUT_MS  (100)
+#define MAX_PACKET_SIZE     (65536)
+
+static double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static double systemNow() {
+    return std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// Heap order: earliest sample first, then arrival
+struct LaterThan {
+    template <typename T>
+    bool operator()(const T& a, const T& b) const {
+        return a.sample != b.sample ? a.sample > b.sample : a.order > b.order;
+    }
+};
+
+OscControl::OscControl(float sampleRate, int queueCapacity)
+    : sampleRate(sampleRate)
+    , latency(0.01)
+    , voiceCount(0)
+    , head(0)
+    , tail(0)
+    , nextOrder(0)
+    , sampleTime(0)
+    , clockOrigin(0)
+    , clockStarted(false)
+    , socket(-1)
+    , port(0)
+    , running(false)
+    , received(0), dropped(0), late(0), errors(0) {
+    uint32_t size = 1;
+    while (size < (uint32_t) queueCapacity) size <<= 1;
+    ring.reset(new t_oscCommand[size]);
+    mask = size - 1;
+    pending.reserve(size);
+    for (int i = 0; i < OSC_MAX_VOICES; i++) voices[i] = nullptr;
+}
+
+OscControl::~OscControl() {
+    stop();
+}
+
+void OscControl::setVoice(int index, PinkTrombone* voice) {
+    if (index < 0 || index >= OSC_MAX_VOICES) return;
+    voices[index] = voice;
+    voiceCount = 0;
+    for (int i = 0; i < OSC_MAX_VOICES; i++) {
+        if (voices[i]) voiceCount = i + 1;
+    }
+}
+
+#ifndef _WIN32
+
+bool OscControl::start(int port, const std::string& bindAddress) {
+    if (running) return false;
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((uint16_t) port);
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (!bindAddress.empty() && inet_pton(AF_INET, bindAddress.c_str(), &address.sin_addr) != 1) return false;
+
+    socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket < 0) return false;
+    timeval timeout = { 0, RECEIVE_TIMEOUT_MS * 1000 };
+    setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    socklen_t length = sizeof(address);
+    if (bind(socket, (const sockaddr*) &address, sizeof(address)) != 0
+        || getsockname(socket, (sockaddr*) &address, &length) != 0) {
+        ::close(socket);
+        socket = -1;
+        return false;
+    }
+    this->port = ntohs(address.sin_port);
+    running = true;
+    thread = std::thread(&OscControl::receive, this);
+    return true;
+}
+
+void OscControl::stop() {
+    if (!running.exchange(false)) return;
+    thread.join();
+    ::close(socket);
+    socket = -1;
+}
+
+void OscControl::receive() {
+    std::vector<char> buffer(MAX_PACKET_SIZE);
+    while (running) {
+        ssize_t size = recv(socket, buffer.data(), buffer.size(), 0);
+        if (size > 0) handlePacket(buffer.data(), (size_t) size);
+    }
+}
+
+#else
+
+bool OscControl::start(int port, const std::string& bindAddress) { return false; }
+void OscControl::stop() {}
+void OscControl::receive() {}
+
+#endif
+
+void OscControl::handlePacket(const void* data, size_t size) {
+    // Timetags are converted to the steady clock once per packet
+    double offset = now() - systemNow() + latency;
+    bool valid = OscParser::parse(data, size, [&](const OscMessage& message, uint64_t timetag) {
+        t_oscCommand command;
+        if (!parseCommand(message, command)) {
+            errors.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        command.time = timetag == OSC_IMMEDIATELY ? -1.0 : oscTimeToSeconds(timetag) + offset;
+        received.fetch_add(1, std::memory_order_relaxed);
+        if (!push(command)) dropped.fetch_add(1, std::memory_order_relaxed);
+    });
+    if (!valid) errors.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool OscControl::parseCommand(const OscMessage& message, t_oscCommand& command) {
+    const char* p = message.getAddress();
+    if (strncmp(p, "/voice/", 7) != 0) return false;
+    p += 7;
+    if (*p == '*') {
+        command.voice = -1;
+        p++;
+    } else {
+        char* end;
+        long voice = strtol(p, &end, 10);
+        if (end == p || voice < 0 || voice >= OSC_MAX_VOICES) return false;
+        command.voice = (int16_t) voice;
+        p = end;
+    }
+    if (*p++ != '/') return false;
+
+    int arguments = message.getArgumentCount();
+    command.slot = 0;
+    for (int i = 0; i < 3; i++) command.values[i] = message.getFloat(i);
+
+    if (strcmp(p, "frequency") == 0) {
+        command.parameter = OSC_FREQUENCY;
+        return arguments >= 1;
+    }
+    if (strcmp(p, "tenseness") == 0) {
+        command.parameter = OSC_TENSENESS;
+        return arguments >= 1;
+    }
+    if (strcmp(p, "tongue") == 0) {
+        command.parameter = OSC_TONGUE;
+        return arguments >= 2;
+    }
+    if (strcmp(p, "vibrato") == 0) {
+        command.parameter = OSC_VIBRATO;
+        return arguments >= 2;
+    }
+    if (strcmp(p, "pan") == 0) {
+        command.parameter = OSC_PAN;
+        return arguments >= 1;
+    }
+    if (strcmp(p, "articulation") == 0) {
+        command.parameter = OSC_ARTICULATION;
+        int articulation = message.getInt(0);
+        command.values[0] = (float) articulation;
+        return arguments >= 1 && articulation >= 0 && articulation < NUM_ARTICULATIONS;
+    }
+    if (strncmp(p, "constriction", 12) == 0) {
+        command.parameter = OSC_CONSTRICTION;
+        p += 12;
+        if (*p == '/') {
+            char* end;
+            long slot = strtol(p + 1, &end, 10);
+            if (end == p + 1 || *end || slot < 0 || slot >= MAX_CONSTRICTIONS) return false;
+            command.slot = (uint8_t) slot;
+            return arguments >= 3;
+        }
+        return *p == 0 && arguments >= 2;
+    }
+    return false;
+}
+
+bool OscControl::push(const t_oscCommand& command) {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) > mask) return false;
+    ring[h & mask] = command;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+void OscControl::beginBlock() {
+    // Follow the system clock with the sample clock
+    double t = now();
+    double error = t - (clockOrigin + sampleTime / (double) sampleRate);
+    if (!clockStarted || std::fabs(error) > CLOCK_RESET) {
+        clockOrigin = t - sampleTime / (double) sampleRate;
+        clockStarted = true;
+    } else {
+        clockOrigin += error * CLOCK_SMOOTHING;
+    }
+
+    uint32_t h = head.load(std::memory_order_acquire);
+    for (uint32_t i = tail.load(std::memory_order_relaxed); i != h; i++) {
+        const t_oscCommand& command = ring[i & mask];
+        if (pending.size() == pending.capacity()) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        Pending p;
+        p.sample = command.time < 0 ? LLONG_MIN
+            : (int64_t) std::llround((command.time - clockOrigin) * sampleRate);
+        p.order = nextOrder++;
+        p.command = command;
+        pending.push_back(p);
+        std::push_heap(pending.begin(), pending.end(), LaterThan());
+    }
+    tail.store(h, std::memory_order_release);
+}
+
+int OscControl::applyDue(int done, int numFrames) {
+    int64_t now = (int64_t) (sampleTime + done);
+    while (!pending.empty() && pending.front().sample <= now) {
+        const Pending& p = pending.front();
+        if (p.sample != LLONG_MIN && p.sample < (int64_t) sampleTime) late.fetch_add(1, std::memory_order_relaxed);
+        apply(p.command);
+        std::pop_heap(pending.begin(), pending.end(), LaterThan());
+        pending.pop_back();
+    }
+    if (pending.empty()) return numFrames;
+    return (int) std::min<int64_t>(numFrames, pending.front().sample - (int64_t) sampleTime);
+}
+
+void OscControl::apply(const t_oscCommand& command) {
+    if (command.voice >= 0) {
+        if (command.voice < voiceCount && voices[command.voice]) apply(voices[command.voice], command);
+        return;
+    }
+    for (int i = 0; i < voiceCount; i++) {
+        if (voices[i]) apply(voices[i], command);
+    }
+}
+
+void OscControl::apply(PinkTrombone* voice, const t_oscCommand& command) {
+    const float* v = command.values;
+    switch (command.parameter) {
+        case OSC_FREQUENCY: voice->setFrequency(v[0]); break;
+        case OSC_TENSENESS: voice->setTenseness(v[0]); break;
+        case OSC_TONGUE: voice->setTonguePosition(v[0], v[1]); break;
+        case OSC_CONSTRICTION:
+            if (command.slot == 0) voice->setConstriction(v[0], v[1], v[2]);
+            else voice->setConstriction((int) command.slot, v[0], v[1], v[2]);
+            break;
+        case OSC_VIBRATO: voice->setVibrato(v[0], v[1]); break;
+        case OSC_ARTICULATION: voice->setArticulation((t_articulation) (int) v[0]); break;
+        case OSC_PAN: voice->setPan(v[0]); break;
+    }
+}
+
+void OscControl::render(float* output, int numFrames, int numChannels, bool accumulate) {
+    process(numFrames, [&](int offset, int frames) {
+        float* slice = output + offset * numChannels;
+        bool first = true;
+        for (int i = 0; i < voiceCount; i++) {
+            if (!voices[i]) continue;
+            voices[i]->synthesize(slice, frames, numChannels, accumulate || !first);
+            first = false;
+        }
+        if (first && !accumulate) memset(slice, 0, frames * numChannels * sizeof(float));
+    });
+}
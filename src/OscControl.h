@@ -0,0 +1,146 @@
+//==============================================================================
+// src/OscControl.h - Open Sound Control over UDP for PinkTrombone voices
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PinkTrombone.h"
+#include "core/OscPacket.h"
+
+#define OSC_MAX_VOICES      (64)
+
+typedef enum t_oscParameter {
+    OSC_FREQUENCY,          // f
+    OSC_TENSENESS,          // f
+    OSC_TONGUE,             // index, diameter
+    OSC_CONSTRICTION,       // index, diameter, fricative; slot in the command
+    OSC_VIBRATO,            // amount, frequency
+    OSC_ARTICULATION,       // t_articulation
+    OSC_PAN                 // -1 to 1
+} t_oscParameter;
+
+// A parsed message, as queued for the audio thread
+typedef struct t_oscCommand {
+    double time;            // steady clock seconds, or < 0 to apply at once
+    int16_t voice;          // -1 for every voice
+    uint8_t parameter;      // t_oscParameter
+    uint8_t slot;           // of a constriction
+    float values[3];
+} t_oscCommand;
+
+// Receives OSC packets on a UDP port and applies them to voices on the
+// audio thread. Parsing happens on a receiver thread, which hands commands to
+// the audio thread through a single-producer, single-consumer ring that
+// neither side waits on; commands are dropped when it is full.
+//
+// Addresses, where N is a voice index given to setVoice() or * for all:
+//   /voice/N/frequency f             /voice/N/tenseness f
+//   /voice/N/tongue index diameter   /voice/N/vibrato amount frequency
+//   /voice/N/constriction index diameter [fricative]
+//   /voice/N/constriction/S index diameter fricative     slot S
+//   /voice/N/articulation i          /voice/N/pan f
+// Numeric arguments may be of any numeric type.
+//
+// Messages outside a bundle, and bundles timed OSC_IMMEDIATELY, apply at the
+// start of the next block. Timed bundles apply at the sample their timetag
+// falls on, plus setLatency(), so a sender can schedule events ahead with
+// sample-accurate spacing: process() splits the block at every command. The
+// sample clock is mapped to the system clock at the first block and then
+// follows it slowly, smoothing out callback jitter while tracking drift.
+// Commands that arrive too late apply at once and are counted.
+class OscControl {
+public:
+    // queueCapacity is rounded up to a power of two; the same number of timed
+    // commands can wait for their sample
+    OscControl(float sampleRate, int queueCapacity = 1024);
+    ~OscControl();
+
+    // Configuration, before start()
+    void setVoice(int index, PinkTrombone* voice);
+    void setLatency(double seconds) { latency = seconds; }  // 0.01 by default
+
+    // Binds a UDP socket, on all interfaces unless bindAddress is given, and
+    // starts the receiver thread. Port 0 picks a free port, see getPort().
+    // POSIX only; fails elsewhere.
+    bool start(int port, const std::string& bindAddress = "");
+    void stop();
+    bool isRunning() const { return running; }
+    int getPort() const { return port; }
+
+    // Audio thread. Applies the commands due within the next numFrames and
+    // calls render(offset, frames) for each run of frames between them; every
+    // call to process() advances the sample clock by numFrames.
+    template <typename Render>
+    void process(int numFrames, Render render) {
+        beginBlock();
+        for (int done = 0; done < numFrames; ) {
+            int next = applyDue(done, numFrames);
+            if (next > done) render(done, next - done);
+            done = next;
+        }
+        sampleTime += numFrames;
+    }
+    // Renders and mixes the voices given to setVoice(), see PinkTrombone::synthesize()
+    void render(float* output, int numFrames, int numChannels, bool accumulate = false);
+    uint64_t getSampleTime() const { return sampleTime; }
+
+    // Any thread
+    long getReceivedCount() const { return received.load(std::memory_order_relaxed); }
+    long getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    long getLateCount() const { return late.load(std::memory_order_relaxed); }
+    // Malformed packets and unknown addresses
+    long getErrorCount() const { return errors.load(std::memory_order_relaxed); }
+
+    // Receiver thread side, exposed so packets can also be fed from elsewhere,
+    // e.g. another transport; only one thread may call it at a time
+    void handlePacket(const void* data, size_t size);
+
+private:
+    OscControl(const OscControl&) = delete;
+    OscControl& operator=(const OscControl&) = delete;
+
+    struct Pending {
+        int64_t sample;
+        uint64_t order;         // keeps commands due at the same sample in arrival order
+        t_oscCommand command;
+    };
+
+    void receive();
+    bool parseCommand(const OscMessage& message, t_oscCommand& command);
+    bool push(const t_oscCommand& command);
+    void beginBlock();
+    int applyDue(int done, int numFrames);
+    void apply(const t_oscCommand& command);
+    void apply(PinkTrombone* voice, const t_oscCommand& command);
+
+    float sampleRate;
+    double latency;
+    PinkTrombone* voices[OSC_MAX_VOICES];
+    int voiceCount;                 // highest index set, plus one
+
+    // Ring from the receiver thread to the audio thread
+    std::unique_ptr<t_oscCommand[]> ring;
+    uint32_t mask;
+    std::atomic<uint32_t> head;     // written by the receiver
+    std::atomic<uint32_t> tail;     // written by the audio thread
+
+    // Audio thread: timed commands in a heap ordered by sample, the sample
+    // clock and its mapping to the steady clock
+    std::vector<Pending> pending;
+    uint64_t nextOrder;
+    uint64_t sampleTime;
+    double clockOrigin;             // steady clock seconds at sample 0
+    bool clockStarted;
+
+    int socket;
+    int port;
+    std::atomic<bool> running;
+    std::thread thread;
+
+    std::atomic<long> received, dropped, late, errors;
+};
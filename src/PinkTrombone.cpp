@@ -4,14 +4,79 @@
 
 #include "PinkTrombone.h"
 
-PinkTrombone::PinkTrombone(float sampleRate)
+static std::atomic<int> voiceCount(0);
+
+static const int noiseLength = 1024;
+static const int logCapacity = 256;
+
+static_assert(std::is_trivially_copyable<Glottis>::value, "Glottis is snapshotted with memcpy");
+static_assert(std::is_trivially_copyable<Biquad>::value, "Biquad is snapshotted with memcpy");
+static_assert(std::is_trivially_copyable<FormantFilter>::value, "FormantFilter is snapshotted with memcpy");
+static_assert(std::is_trivially_copyable<t_areaFunction>::value, "Area functions are snapshotted with memcpy");
+
+// Control-rate state included in voice snapshots
+float PinkTrombone::* const PinkTrombone::snapshotParameters[] = {
+    &PinkTrombone::smoothingTime,
+    &PinkTrombone::targetFrequency, &PinkTrombone::currentFrequency,
+    &PinkTrombone::targetTenseness, &PinkTrombone::currentTenseness,
+    &PinkTrombone::targetTongueIndex, &PinkTrombone::currentTongueIndex,
+    &PinkTrombone::targetTongueDiameter, &PinkTrombone::currentTongueDiameter,
+    &PinkTrombone::targetConstrictionIndex, &PinkTrombone::currentConstrictionIndex,
+    &PinkTrombone::targetConstrictionDiameter, &PinkTrombone::currentConstrictionDiameter,
+    &PinkTrombone::targetFricative, &PinkTrombone::currentFricative
+};
+const int PinkTrombone::numSnapshotParameters = sizeof(snapshotParameters) / sizeof(snapshotParameters[0]);
+
+static bool sameAreaFunction(const t_areaFunction& a, const t_areaFunction& b) {
+    return a.n == b.n && a.velum == b.velum
+        && memcmp(a.diameter, b.diameter, a.n * sizeof(sample_t)) == 0;
+}
+
+static int supportedTractLength(int tractLength) {
+    return tractLength == 22 ? 22 : 44;
+}
+
+size_t PinkTrombone::getArenaSize(int tractLength, t_tractPrecision precision) {
+    int n = supportedTractLength(tractLength);
+    int noseLength = NOSE_LENGTH * n / (int) NUM_CONSTRICTIONS;
+    return VoiceArena::align(sizeof(WhiteNoise))
+        + VoiceArena::align(noiseLength * sizeof(sample_t))
+        + VoiceArena::align(sizeof(Biquad)) * 2
+        + VoiceArena::align(sizeof(Glottis))
+        + VoiceArena::align(Tract::getSize(n, precision))
+        + VoiceArena::align(sizeof(FormantFilter))
+        + VoiceArena::align(n * sizeof(sample_t))
+        + VoiceArena::align(noseLength * sizeof(sample_t))
+        + VoiceArena::align(logCapacity * sizeof(t_logRecord))
+#ifdef PINK_TROMBONE_PROFILE
+        + VoiceArena::align(sizeof(Profiler))
+#endif
+        + VoiceArena::align(getMaxStateSize(n, precision));
+}
+
+PinkTrombone::PinkTrombone(float sampleRate, int tractLength, t_tractPrecision precision, void* arenaMemory)
     : sampleRate(sampleRate)
-    , blockTime(1.0f / sampleRate)
+    , blockTime((float) CONTROL_BLOCK_SIZE / sampleRate)
+    , controlInterval(CONTROL_BLOCK_SIZE)
+    , pendingControlInterval(CONTROL_BLOCK_SIZE)
+    , level(0.0f)
+    , arena(getArenaSize(tractLength, precision), arenaMemory)
     , glottis(nullptr)
     , tract(nullptr)
     , whiteNoise(nullptr)
     , aspirateFilter(nullptr)
     , fricativeFilter(nullptr)
+    , formantFilter(nullptr)
+    , engine(VOICE_ENGINE_WAVEGUIDE)
+    , pendingEngine(VOICE_ENGINE_WAVEGUIDE)
+    , diagnosticLog("voice " + std::to_string(voiceCount++),
+                    arena.allocateArray<t_logRecord>(logCapacity), logCapacity)
+    , sampleCount(0)
+    , controlPosition(0)
+    , mathQuality(PINK_TROMBONE_MATH_QUALITY)
+    , seed(((uint32_t) (uint16_t) timeseed() << 16) ^ (uint32_t) voiceCount.load())
+    , logInterval((int) (sampleRate * 0.1f / CONTROL_BLOCK_SIZE))
+    , logCounter(0)
     , smoothingTime(0.1f)
     , targetFrequency(140.0f), currentFrequency(140.0f)
     , targetTenseness(0.6f), currentTenseness(0.6f)
@@ -19,17 +84,36 @@ PinkTrombone::PinkTrombone(float sampleRate)
     , targetTongueDiameter(4.43f), currentTongueDiameter(4.43f)
     , targetConstrictionIndex(-1.0f), currentConstrictionIndex(-1.0f)
     , targetConstrictionDiameter(1.0f), currentConstrictionDiameter(1.0f)
-    , targetFricative(0.0f), currentFricative(0.0f) {
+    , targetFricative(0.0f), currentFricative(0.0f)
+    , pan(0.0f), panLeft(cosf(0.25f * (float)M_PI)), panRight(sinf(0.25f * (float)M_PI))
+    , lipChannel(-1), noseChannel(-1)
+    , profiler(nullptr)
+    , presets(&ArticulationPresets::getDefault(supportedTractLength(tractLength)))
+    , recoveryState(nullptr)
+    , initialState(nullptr)
+    , recoveryCount(0)
+    , fadeIn(1.0f)
+    , fadeInStep(1.0f / (float) (RECOVERY_FADE_TIME * sampleRate)) {
     
-    // Initialize tract properties
-    initializeTractProps(&tractProps, 44);
+    // Create synthesis components inside the arena, in the order the
+    // per-sample loop touches them
+    int n = supportedTractLength(tractLength);
+    whiteNoise = arena.create<WhiteNoise>(noiseLength, arena.allocateArray<sample_t>(noiseLength));
+    fricativeFilter = arena.create<Biquad>(sampleRate);
+    glottis = arena.create<Glottis>(sampleRate, blockTime);
+    void* tractMemory = arena.allocate(Tract::getSize(n, precision));
+    aspirateFilter = arena.create<Biquad>(sampleRate);
+    formantFilter = arena.create<FormantFilter>(sampleRate);
     
-    // Create synthesis components
-    glottis = new Glottis(sampleRate);
-    tract = new Tract(sampleRate, blockTime, &tractProps);
-    whiteNoise = new WhiteNoise(1024);
-    aspirateFilter = new Biquad(sampleRate);
-    fricativeFilter = new Biquad(sampleRate);
+    // Initialize tract properties
+    int noseLength = NOSE_LENGTH * n / (int) NUM_CONSTRICTIONS;
+    initializeTractProps(&tractProps, n, arena.allocateArray<sample_t>(n),
+                         arena.allocateArray<sample_t>(noseLength));
+    tract = Tract::create(tractMemory, sampleRate, blockTime, &tractProps, precision);
+    setSeed(seed);
+#ifdef PINK_TROMBONE_PROFILE
+    profiler = arena.create<Profiler>(diagnosticLog.getName());
+#endif
     
     // Setup filters
     aspirateFilter->setFrequency(500.0f);
@@ -37,52 +121,266 @@ PinkTrombone::PinkTrombone(float sampleRate)
     fricativeFilter->setFrequency(1000.0f);
     fricativeFilter->setQ(0.5f);
     
+    for (Constriction& c : constrictions) {
+        c.targetIndex = c.currentIndex = -1.0f;
+        c.targetDiameter = c.currentDiameter = 1.0f;
+        c.targetFricative = c.currentFricative = 0.0f;
+    }
+    
+    articulation.active = false;
+    articulation.targetMorph = articulation.currentMorph = 0.0f;
+    articulation.from = articulation.to = articulation.shape = presets->get(ARTICULATION_A);
+    
     // Set initial vowel (A)
     tract->setRestDiameter(targetTongueIndex, targetTongueDiameter);
-        
-    cout << "Tract length: " << tractProps.n << endl;
-    cout << "Tongue bounds: " << tract->tongueIndexLowerBound() << " to " << tract->tongueIndexUpperBound() << endl;
-    cout << "Blade start: " << tractProps.bladeStart << ", Tip start: " << tractProps.tipStart << endl;
-
+    tract->setDiagnosticLog(&diagnosticLog);
+    tract->setProfiler(profiler);
+    
+    float info[] = {
+        (float) tractProps.n,
+        (float) tract->tongueIndexLowerBound(), (float) tract->tongueIndexUpperBound(),
+        (float) tractProps.bladeStart, (float) tractProps.tipStart
+    };
+    diagnosticLog.push(LOG_TRACT_INFO, info, 5);
+    
+    shapeSnapshot.publish(tractProps, sampleRate);
+    publishedShapeVersion = tractProps.shapeVersion;
+    
+    // Unstable voices fall back to this state, see setRecoveryState()
+    initialState = arena.allocateArray<unsigned char>((long) getStateSize());
+    writeState(initialState);
+    recoveryState = initialState;
 }
 
 PinkTrombone::~PinkTrombone() {
-    delete glottis;
-    delete tract;
-    delete whiteNoise;
-    delete aspirateFilter;
-    delete fricativeFilter;
-    
-    if (tractProps.tractDiameter) free(tractProps.tractDiameter);
-    if (tractProps.noseDiameter) free(tractProps.noseDiameter);
+    // Components live in the arena, which releases the memory itself
+    glottis->~Glottis();
+    tract->~Tract();
+    whiteNoise->~WhiteNoise();
+    aspirateFilter->~Biquad();
+    fricativeFilter->~Biquad();
+    formantFilter->~FormantFilter();
+    if (profiler) profiler->~Profiler();
 }
 
 void PinkTrombone::synthesize(float* output, int bufferSize) {
+    synthesize(output, bufferSize, 1);
+}
+
+static inline float readInput(const ModulationBuffer& buffer, int frame, float min, float max) {
+    return std::min(std::max(buffer.data[frame * buffer.stride], min), max);
+}
+
+void PinkTrombone::synthesize(float* output, int bufferSize, int numChannels, bool accumulate) {
+    render(output, bufferSize, numChannels, accumulate, nullptr);
+}
+
+void PinkTrombone::synthesize(float* output, int numFrames, int numChannels,
+                              const ModulationInputs& inputs, bool accumulate) {
+    render(output, numFrames, numChannels, accumulate, &inputs);
+    
+    // Hand over to the setters and smoothers from the last input values
+    glottis->releaseAudioRateInputs();
+    if (numFrames <= 0) return;
+    int last = numFrames - 1;
+    if (inputs.frequency.data) targetFrequency = currentFrequency = readInput(inputs.frequency, last, 50.0f, 800.0f);
+    if (inputs.tenseness.data) targetTenseness = currentTenseness = readInput(inputs.tenseness, last, 0.0f, 1.0f);
+    if (inputs.tongueIndex.data) targetTongueIndex = inputs.tongueIndex.data[last * inputs.tongueIndex.stride];
+    if (inputs.tongueDiameter.data) targetTongueDiameter = inputs.tongueDiameter.data[last * inputs.tongueDiameter.stride];
+    if (inputs.constrictionIndex.data) targetConstrictionIndex = inputs.constrictionIndex.data[last * inputs.constrictionIndex.stride];
+    if (inputs.constrictionDiameter.data) targetConstrictionDiameter = inputs.constrictionDiameter.data[last * inputs.constrictionDiameter.stride];
+    if (inputs.fricative.data) targetFricative = readInput(inputs.fricative, last, 0.0f, 1.0f);
+}
+
+// Tract inputs are sampled at control rate: they bypass the smoothers by
+// moving target and current together
+void PinkTrombone::applyControlInputs(const ModulationInputs& inputs, int frame) {
+    if (inputs.tongueIndex.data || inputs.tongueDiameter.data) articulation.active = false;
+    if (inputs.tongueIndex.data) {
+        targetTongueIndex = currentTongueIndex = inputs.tongueIndex.data[frame * inputs.tongueIndex.stride];
+    }
+    if (inputs.tongueDiameter.data) {
+        targetTongueDiameter = currentTongueDiameter = inputs.tongueDiameter.data[frame * inputs.tongueDiameter.stride];
+    }
+    if (inputs.constrictionIndex.data) {
+        targetConstrictionIndex = currentConstrictionIndex = inputs.constrictionIndex.data[frame * inputs.constrictionIndex.stride];
+    }
+    if (inputs.constrictionDiameter.data) {
+        targetConstrictionDiameter = currentConstrictionDiameter = inputs.constrictionDiameter.data[frame * inputs.constrictionDiameter.stride];
+    }
+    if (inputs.fricative.data) {
+        targetFricative = currentFricative = readInput(inputs.fricative, frame, 0.0f, 1.0f);
+    }
+    if (inputs.frequency.data) {
+        targetFrequency = currentFrequency = readInput(inputs.frequency, frame, 50.0f, 800.0f);
+    }
+    if (inputs.tenseness.data) {
+        targetTenseness = currentTenseness = readInput(inputs.tenseness, frame, 0.0f, 1.0f);
+    }
+}
+
+void PinkTrombone::render(float* output, int bufferSize, int numChannels, bool accumulate,
+                          const ModulationInputs* inputs) {
+    REALTIME_SCOPE();
+    metrics.beginBlock();
+#ifdef PINK_TROMBONE_PROFILE
+    profiler->beginBlock(bufferSize);
+#endif
+    
+    diagnosticLog.setSampleTime(sampleCount);
+    bool loggedNaN = false;
+    
+    // Pan gains ramp from the previous block's values to avoid zipper noise
+    float startLeft = panLeft, startRight = panRight;
+    float angle = (pan + 1.0f) * 0.25f * (float)M_PI;
+    panLeft = cosf(angle);
+    panRight = sinf(angle);
+    float stepLeft = (panLeft - startLeft) / (float)bufferSize;
+    float stepRight = (panRight - startRight) / (float)bufferSize;
+    
+    int lipBus = lipChannel < numChannels ? lipChannel : -1;
+    int noseBus = noseChannel < numChannels ? noseChannel : -1;
+    float energy = 0.0f;
+    
     for (int i = 0; i < bufferSize; i++) {
-        updateParameters();
+        // Control-rate updates at the start of each internal block, which
+        // may have begun in an earlier call
+        if (controlPosition == 0) {
+            PROFILE_SCOPE(profiler, PROFILE_CONTROL);
+            if (pendingControlInterval != controlInterval) applyControlInterval();
+            if (pendingEngine != engine) applyEngine();
+            if (inputs) applyControlInputs(*inputs, i);
+            updateParameters();
+            if (articulation.active) updateAreaFunction();
+        }
         
         // Generate noise sources
-        float noiseSource = whiteNoise->runStep();
-        float turbulenceNoise = fricativeFilter->runStep(noiseSource);
+        float noiseSource, turbulenceNoise;
+        {
+            PROFILE_SCOPE(profiler, PROFILE_NOISE);
+            noiseSource = whiteNoise->runStep();
+            turbulenceNoise = fricativeFilter->runStep(noiseSource);
+        }
         
         // Generate glottal source
-        float lambda = (float)i / (float)bufferSize;
-        float glottalOutput = glottis->runStep(lambda, noiseSource);
-        float glottalNoiseModulator = glottis->getNoiseModulator();
+        float lambda = (float)controlPosition / (float)controlInterval;
+        float glottalOutput, glottalNoiseModulator;
+        {
+            PROFILE_SCOPE(profiler, PROFILE_GLOTTIS);
+            if (inputs) {
+                if (inputs->frequency.data) glottis->setAudioRateFrequency(readInput(inputs->frequency, i, 50.0f, 800.0f));
+                if (inputs->tenseness.data) glottis->setAudioRateTenseness(readInput(inputs->tenseness, i, 0.0f, 1.0f));
+            }
+            glottalOutput = glottis->runStep(lambda, noiseSource);
+            glottalNoiseModulator = glottis->getNoiseModulator();
+        }
         
         // Process through vocal tract
-        tract->runStep(glottalOutput, turbulenceNoise, lambda, glottalNoiseModulator);
+        float lip, nose;
+        if (engine == VOICE_ENGINE_FORMANT) {
+            formantFilter->runStep(glottalOutput, turbulenceNoise, lambda, glottalNoiseModulator);
+            lip = formantFilter->lipOutput;
+            nose = formantFilter->noseOutput;
+        } else {
+            tract->runStep(glottalOutput, turbulenceNoise, lambda, glottalNoiseModulator);
+            lip = tract->lipOutput;
+            nose = tract->noseOutput;
+        }
         
         // Mix outputs
-        output[i] = tract->lipOutput + 0.8f * tract->noseOutput;
+        float mix = lip + 0.8f * nose;
+        
+        if (!std::isfinite(mix) || !std::isfinite(lip) || !std::isfinite(nose)) {
+            if (!loggedNaN) {
+                diagnosticLog.push(LOG_NAN, (float) i);
+                loggedNaN = true;
+            }
+            // Silent until the health check resets the voice
+            mix = lip = nose = 0.0f;
+        }
+        if (fadeIn < 1.0f) {
+            fadeIn = std::min(fadeIn + fadeInStep, 1.0f);
+            mix *= fadeIn;
+            lip *= fadeIn;
+            nose *= fadeIn;
+        }
         
         // Soft limiting
-        output[i] = ofClamp(output[i], -1.0f, 1.0f);
+        mix = ofClamp(mix, -1.0f, 1.0f);
+        energy += mix * mix;
+        
+        // Write the frame in place: panned mix on the first two channels,
+        // then the optional lip and nose buses
+        float* frame = output + i * numChannels;
+        if (numChannels == 1) {
+            frame[0] = accumulate ? frame[0] + mix : mix;
+        } else {
+            float left = mix * (startLeft + stepLeft * i);
+            float right = mix * (startRight + stepRight * i);
+            frame[0] = accumulate ? frame[0] + left : left;
+            frame[1] = accumulate ? frame[1] + right : right;
+        }
+        if (lipBus >= 0) {
+            lip = ofClamp(lip, -1.0f, 1.0f);
+            frame[lipBus] = accumulate ? frame[lipBus] + lip : lip;
+        }
+        if (noseBus >= 0) {
+            nose = ofClamp(nose, -1.0f, 1.0f);
+            frame[noseBus] = accumulate ? frame[noseBus] + nose : nose;
+        }
+        
+        if (++controlPosition >= controlInterval) {
+            PROFILE_SCOPE(profiler, PROFILE_FINISH);
+            finishControlBlock();
+            controlPosition = 0;
+        }
     }
     
-    // Finish processing blocks
+    sampleCount += bufferSize;
+    level = bufferSize > 0 ? sqrtf(energy / (float) bufferSize) : 0.0f;
+    metrics.endBlock(bufferSize, sampleRate);
+#ifdef PINK_TROMBONE_PROFILE
+    profiler->endBlock();
+#endif
+}
+
+void PinkTrombone::finishControlBlock() {
     glottis->finishBlock();
     tract->finishBlock();
+    if (engine == VOICE_ENGINE_FORMANT) {
+        t_constriction active[MAX_CONSTRICTIONS];
+        active[0] = { currentConstrictionIndex, currentConstrictionDiameter, currentFricative };
+        for (int slot = 1; slot < MAX_CONSTRICTIONS; slot++) {
+            const Constriction& c = constrictions[slot - 1];
+            active[slot] = { c.currentIndex, c.currentDiameter, c.currentFricative };
+        }
+        formantFilter->finishBlock(tractProps, active, MAX_CONSTRICTIONS);
+    }
+    if (!isStable()) recover();
+    if (tractProps.shapeVersion != publishedShapeVersion) {
+        shapeSnapshot.publish(tractProps, sampleRate);
+        publishedShapeVersion = tractProps.shapeVersion;
+    }
+}
+
+void PinkTrombone::applyControlInterval() {
+    controlInterval = pendingControlInterval;
+    blockTime = (float) controlInterval / sampleRate;
+    glottis->setBlockTime(blockTime);
+    tract->setBlockTime(blockTime);
+    logInterval = (int) (sampleRate * 0.1f / controlInterval);
+}
+
+// The engine taking over starts from the current tract shape, faded in since
+// it does not carry on where the other one was
+void PinkTrombone::applyEngine() {
+    engine = pendingEngine;
+    if (engine == VOICE_ENGINE_FORMANT) formantFilter->reset(tractProps);
+    fadeIn = 0.0f;
+}
+
+void PinkTrombone::setControlInterval(int samples) {
+    pendingControlInterval = std::min(std::max(samples, 16), 1024);
 }
 
 void PinkTrombone::updateParameters() {
@@ -97,17 +395,42 @@ void PinkTrombone::updateParameters() {
     currentConstrictionDiameter = smoothParameter(currentConstrictionDiameter, targetConstrictionDiameter, deltaTime);
     currentFricative = smoothParameter(currentFricative, targetFricative, deltaTime);
     
-    // DEBUG: Print current values
-    static int debugCounter = 0;
-    if (debugCounter++ % 4410 == 0) {  // Print every 0.1 seconds at 44.1kHz
-        cout << "Tongue: " << currentTongueIndex << ", " << currentTongueDiameter << endl;
+    // Log current values every 0.1 seconds
+    if (logCounter-- <= 0) {
+        float values[] = {
+            currentFrequency, currentTenseness,
+            currentTongueIndex, currentTongueDiameter,
+            currentConstrictionIndex, currentConstrictionDiameter
+        };
+        diagnosticLog.push(LOG_PARAMETERS, values, 6);
+        logCounter = logInterval;
     }
     
     // Apply to synthesis components
     glottis->setTargetFrequency(currentFrequency);
     glottis->setTargetTenseness(currentTenseness);
-    tract->setRestDiameter(currentTongueIndex, currentTongueDiameter);
+    if (!articulation.active) tract->setRestDiameter(currentTongueIndex, currentTongueDiameter, false);
     tract->setConstriction(currentConstrictionIndex, currentConstrictionDiameter, currentFricative);
+    for (int slot = 1; slot < MAX_CONSTRICTIONS; slot++) {
+        Constriction& c = constrictions[slot - 1];
+        // Slots appear and vanish in place rather than sliding along the tract
+        if (c.targetIndex < 0.0f || c.currentIndex < 0.0f) c.currentIndex = c.targetIndex;
+        else c.currentIndex = smoothParameter(c.currentIndex, c.targetIndex, deltaTime);
+        c.currentDiameter = smoothParameter(c.currentDiameter, c.targetDiameter, deltaTime);
+        c.currentFricative = smoothParameter(c.currentFricative, c.targetFricative, deltaTime);
+        if (c.currentIndex < 0.0f) {
+            tract->clearConstriction(slot);
+        } else {
+            t_constriction constriction = { c.currentIndex, c.currentDiameter, c.currentFricative };
+            tract->setConstriction(slot, constriction);
+        }
+    }
+}
+
+void PinkTrombone::updateAreaFunction() {
+    articulation.currentMorph = smoothParameter(articulation.currentMorph, articulation.targetMorph, blockTime);
+    blendAreaFunctions(articulation.from, articulation.to, articulation.currentMorph, articulation.shape);
+    tract->setRestShape(articulation.shape.diameter, articulation.shape.velum, false);
 }
 
 float PinkTrombone::smoothParameter(float current, float target, float deltaTime) {
@@ -117,6 +440,148 @@ float PinkTrombone::smoothParameter(float current, float target, float deltaTime
     return current + factor * (target - current);
 }
 
+bool PinkTrombone::isStable() {
+    return tract->isStable() && aspirateFilter->isStable() && fricativeFilter->isStable()
+        && formantFilter->isStable();
+}
+
+static bool isFinite(const t_areaFunction& shape) {
+    if (!std::isfinite(shape.velum)) return false;
+    for (int i = 0; i < shape.n; i++) {
+        if (!std::isfinite(shape.diameter[i])) return false;
+    }
+    return true;
+}
+
+// Back to the recovery state's DSP state, keeping the parameters unless they
+// are what went wrong. The noise position and the control block position are
+// left alone: neither can be unstable, and the block carries on.
+void PinkTrombone::recover() {
+    const unsigned char* p = recoveryState;
+    memcpy(glottis, p, sizeof(Glottis));                p += sizeof(Glottis);
+    glottis->setMathQuality(mathQuality);
+    glottis->setSeed((short) randomMix(seed + 1));
+    glottis->setBlockTime(blockTime);
+    memcpy(aspirateFilter, p, sizeof(Biquad));          p += sizeof(Biquad);
+    memcpy(fricativeFilter, p, sizeof(Biquad));         p += sizeof(Biquad);
+    p += sizeof(long) + sizeof(int);
+    tract->restoreState(p);                             p += tract->getStateSize();
+    tract->setSeed(seed + 2);
+    tract->setBlockTime(blockTime);
+    memcpy(formantFilter, p, sizeof(FormantFilter));    p += sizeof(FormantFilter);
+    for (int i = 0; i < numSnapshotParameters; i++) {
+        float& value = this->*snapshotParameters[i];
+        if (!std::isfinite(value)) memcpy(&value, p, sizeof(float));
+        p += sizeof(float);
+    }
+    if (!std::isfinite(articulation.targetMorph) || !std::isfinite(articulation.currentMorph)
+        || !isFinite(articulation.from) || !isFinite(articulation.to) || !isFinite(articulation.shape)) {
+        memcpy(&articulation, p, sizeof(Articulation));
+    }
+    p += sizeof(Articulation);
+    for (Constriction& c : constrictions) {
+        Constriction saved;
+        memcpy(&saved, p, sizeof(Constriction));        p += sizeof(Constriction);
+        if (!std::isfinite(c.targetIndex)) c.targetIndex = saved.targetIndex;
+        if (!std::isfinite(c.currentIndex)) c.currentIndex = saved.currentIndex;
+        if (!std::isfinite(c.targetDiameter)) c.targetDiameter = saved.targetDiameter;
+        if (!std::isfinite(c.currentDiameter)) c.currentDiameter = saved.currentDiameter;
+        if (!std::isfinite(c.targetFricative)) c.targetFricative = saved.targetFricative;
+        if (!std::isfinite(c.currentFricative)) c.currentFricative = saved.currentFricative;
+    }
+    
+    fadeIn = 0.0f;
+    long count = recoveryCount.load(std::memory_order_relaxed) + 1;
+    recoveryCount.store(count, std::memory_order_relaxed);
+    diagnosticLog.push(LOG_RECOVERY, (float) count);
+}
+
+bool PinkTrombone::setRecoveryState(const VoiceState* state) {
+    if (!state) {
+        recoveryState = initialState;
+        return true;
+    }
+    if (state->sampleRate != sampleRate || state->tractLength != tractProps.n
+        || state->precision != tract->getPrecision() || state->data.size() != getStateSize()) {
+        return false;
+    }
+    recoveryState = state->data.data();
+    return true;
+}
+
+size_t PinkTrombone::getStateSize() {
+    return sizeof(Glottis) + 2 * sizeof(Biquad) + sizeof(long) + sizeof(int)
+        + tract->getStateSize() + sizeof(FormantFilter) + numSnapshotParameters * sizeof(float)
+        + sizeof(Articulation) + sizeof(constrictions);
+}
+
+// Bound on getStateSize() before the tract exists: its state is part of it
+size_t PinkTrombone::getMaxStateSize(int tractLength, t_tractPrecision precision) {
+    return sizeof(Glottis) + 2 * sizeof(Biquad) + sizeof(long) + sizeof(int)
+        + Tract::getSize(tractLength, precision) + sizeof(FormantFilter)
+        + numSnapshotParameters * sizeof(float)
+        + sizeof(Articulation) + sizeof(constrictions);
+}
+
+void PinkTrombone::saveState(VoiceState& state) {
+    state.sampleRate = sampleRate;
+    state.tractLength = tractProps.n;
+    state.precision = tract->getPrecision();
+    state.data.resize(getStateSize());
+    writeState(state.data.data());
+}
+
+void PinkTrombone::writeState(unsigned char* p) {
+    memcpy(p, glottis, sizeof(Glottis));                p += sizeof(Glottis);
+    memcpy(p, aspirateFilter, sizeof(Biquad));          p += sizeof(Biquad);
+    memcpy(p, fricativeFilter, sizeof(Biquad));         p += sizeof(Biquad);
+    long noisePosition = whiteNoise->getPosition();
+    memcpy(p, &noisePosition, sizeof(long));            p += sizeof(long);
+    memcpy(p, &controlPosition, sizeof(int));           p += sizeof(int);
+    tract->saveState(p);                                p += tract->getStateSize();
+    memcpy(p, formantFilter, sizeof(FormantFilter));    p += sizeof(FormantFilter);
+    for (int i = 0; i < numSnapshotParameters; i++) {
+        memcpy(p, &(this->*snapshotParameters[i]), sizeof(float));
+        p += sizeof(float);
+    }
+    memcpy(p, &articulation, sizeof(Articulation));   p += sizeof(Articulation);
+    memcpy(p, constrictions, sizeof(constrictions));
+}
+
+bool PinkTrombone::restoreState(const VoiceState& state) {
+    if (state.sampleRate != sampleRate || state.tractLength != tractProps.n
+        || state.precision != tract->getPrecision() || state.data.size() != getStateSize()) {
+        return false;
+    }
+    readState(state.data.data());
+    return true;
+}
+
+void PinkTrombone::readState(const unsigned char* p) {
+    memcpy(glottis, p, sizeof(Glottis));                p += sizeof(Glottis);
+    glottis->setMathQuality(mathQuality);   // settings of this voice, not state
+    glottis->setSeed((short) randomMix(seed + 1));
+    glottis->setBlockTime(blockTime);
+    memcpy(aspirateFilter, p, sizeof(Biquad));          p += sizeof(Biquad);
+    memcpy(fricativeFilter, p, sizeof(Biquad));         p += sizeof(Biquad);
+    long noisePosition;
+    memcpy(&noisePosition, p, sizeof(long));            p += sizeof(long);
+    whiteNoise->setPosition(noisePosition);
+    memcpy(&controlPosition, p, sizeof(int));           p += sizeof(int);
+    tract->restoreState(p);                             p += tract->getStateSize();
+    tract->setSeed(seed + 2);
+    tract->setBlockTime(blockTime);
+    memcpy(formantFilter, p, sizeof(FormantFilter));    p += sizeof(FormantFilter);
+    if (controlPosition >= controlInterval) controlPosition = 0;
+    for (int i = 0; i < numSnapshotParameters; i++) {
+        memcpy(&(this->*snapshotParameters[i]), p, sizeof(float));
+        p += sizeof(float);
+    }
+    memcpy(&articulation, p, sizeof(Articulation));   p += sizeof(Articulation);
+    memcpy(constrictions, p, sizeof(constrictions));
+    fadeIn = 1.0f;
+}
+
 void PinkTrombone::setFrequency(float frequency) {
     targetFrequency = ofClamp(frequency, 50.0f, 800.0f);
 }
@@ -126,6 +591,7 @@ void PinkTrombone::setTenseness(float tenseness) {
 }
 
 void PinkTrombone::setTonguePosition(float index, float diameter) {
+    articulation.active = false;
     targetTongueIndex = currentTongueIndex = index;     // Set both target AND current
     targetTongueDiameter = currentTongueDiameter = diameter;  // Skip smoothing
     
@@ -141,6 +607,67 @@ void PinkTrombone::setConstriction(float index, float diameter, float fricative)
     targetFricative = ofClamp(fricative, 0.0f, 1.0f);
 }
 
+void PinkTrombone::setConstriction(int slot, float index, float diameter, float fricative) {
+    if (slot == 0) {
+        setConstriction(index, diameter, fricative);
+        return;
+    }
+    if (slot < 0 || slot >= MAX_CONSTRICTIONS) return;
+    Constriction& c = constrictions[slot - 1];
+    c.targetIndex = index;
+    c.targetDiameter = diameter;
+    c.targetFricative = ofClamp(fricative, 0.0f, 1.0f);
+}
+
+void PinkTrombone::setArticulation(t_articulation preset) {
+    setAreaFunction(presets->get(preset));
+}
+
+void PinkTrombone::setAreaFunction(const t_areaFunction& shape) {
+    morphAreaFunctions(shape, shape, 1.0f);
+}
+
+void PinkTrombone::morphArticulation(t_articulation from, t_articulation to, float amount) {
+    morphAreaFunctions(presets->get(from), presets->get(to), amount);
+}
+
+void PinkTrombone::morphAreaFunctions(const t_areaFunction& from, const t_areaFunction& to, float amount) {
+    if (from.n != tractProps.n || to.n != tractProps.n) return;
+    
+    amount = ofClamp(amount, 0.0f, 1.0f);
+    // A new pair of shapes starts at the requested amount rather than
+    // sliding from the old pair's position
+    bool samePair = articulation.active
+        && sameAreaFunction(articulation.from, from)
+        && sameAreaFunction(articulation.to, to);
+    if (!samePair) {
+        articulation.from = from;
+        articulation.to = to;
+        articulation.currentMorph = amount;
+    }
+    articulation.targetMorph = amount;
+    articulation.active = true;
+}
+
+void PinkTrombone::captureAreaFunction(t_areaFunction& shape) {
+    shape.n = tractProps.n;
+    shape.velum = tractProps.noseDiameter[0];
+    memcpy(shape.diameter, tractProps.tractDiameter, tractProps.n * sizeof(sample_t));
+}
+
+void PinkTrombone::setMathQuality(t_mathQuality quality) {
+    mathQuality = quality;
+    glottis->setMathQuality(quality);
+    tract->setMathQuality(quality);
+}
+
+void PinkTrombone::setSeed(uint32_t seed) {
+    this->seed = seed;
+    whiteNoise->fill(seed);
+    glottis->setSeed((short) randomMix(seed + 1));
+    tract->setSeed(seed + 2);
+}
+
 void PinkTrombone::setVibrato(float amount, float frequency) {
     if (glottis) {
         glottis->vibratoAmount = ofClamp(amount, 0.0f, 0.1f);
@@ -148,6 +675,15 @@ void PinkTrombone::setVibrato(float amount, float frequency) {
     }
 }
 
+void PinkTrombone::setPan(float pan) {
+    this->pan = ofClamp(pan, -1.0f, 1.0f);
+}
+
+void PinkTrombone::setOutputBuses(int lipChannel, int noseChannel) {
+    this->lipChannel = lipChannel;
+    this->noseChannel = noseChannel;
+}
+
 void PinkTrombone::setParameterSmoothingTime(float seconds) {
     smoothingTime = ofClamp(seconds, 0.0f, 2.0f);
 }
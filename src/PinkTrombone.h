@@ -9,44 +9,222 @@
 #include "core/Tract.h"
 #include "core/WhiteNoise.h"
 #include "core/Biquad.h"
+#include "core/RealtimeCheck.h"
+#include "core/DiagnosticLog.h"
+#include "core/DspMetrics.h"
+#include "core/Profiler.h"
+#include "core/VoiceArena.h"
+#include "core/ArticulationPresets.h"
+#include "core/TractShape.h"
+#include "core/FormantFilter.h"
+
+// Snapshot of a voice's complete DSP state, see PinkTrombone::saveState()
+class VoiceState {
+public:
+    bool isValid() const { return !data.empty(); }
+    size_t getSize() const { return data.size(); }
+    
+private:
+    friend class PinkTrombone;
+    float sampleRate = 0;
+    int tractLength = 0;
+    t_tractPrecision precision = TRACT_PRECISION_FLOAT;
+    std::vector<unsigned char> data;
+};
+
+// One per-sample parameter input, read as data[i * stride]
+struct ModulationBuffer {
+    const float* data = nullptr;
+    int stride = 1;
+};
+
+// Optional audio-rate inputs for synthesize(). A supplied buffer overrides the
+// parameter's setter for the block, and its value is used without smoothing.
+// Frequency and tenseness reach the glottis every sample; the tongue and
+// constriction move the tract shape, which is sampled at the start of each
+// control block and interpolated across it.
+struct ModulationInputs {
+    ModulationBuffer frequency;             // Hz
+    ModulationBuffer tenseness;
+    ModulationBuffer tongueIndex, tongueDiameter;
+    ModulationBuffer constrictionIndex, constrictionDiameter, fricative;
+};
+
+// What renders the tract, see PinkTrombone::setEngine()
+typedef enum t_voiceEngine {
+    VOICE_ENGINE_WAVEGUIDE,     // the full waveguide, oral and nasal
+    VOICE_ENGINE_FORMANT        // FormantFilter, a fraction of the cost
+} t_voiceEngine;
 
 class PinkTrombone {
 public:
-    PinkTrombone(float sampleRate);
+    // tractLength is 44 (full) or 22 (reduced) sections; precision selects the
+    // tract's internal sample type independently of sample_t. All components
+    // are placed in one arena of getArenaSize() bytes, allocated here unless
+    // arenaMemory (64-byte aligned) is given, e.g. by a VoicePool.
+    PinkTrombone(float sampleRate, int tractLength = 44,
+                 t_tractPrecision precision = TRACT_PRECISION_FLOAT,
+                 void* arenaMemory = nullptr);
     ~PinkTrombone();
     
     void synthesize(float* output, int bufferSize);
     
+    // Render straight into an interleaved buffer of numChannels channels.
+    // The mix is panned over channels 0 and 1 (mono buffers get it unpanned),
+    // and the lip and nose outputs go to their bus channels when enabled.
+    // With accumulate set, the voice is added to what is already there.
+    // Control-rate work runs every CONTROL_BLOCK_SIZE samples, carried
+    // across calls, so the sound does not depend on the host buffer size.
+    void synthesize(float* output, int numFrames, int numChannels, bool accumulate = false);
+    // Same, with parameters driven per sample from the given buffers. When the
+    // call returns, the last input values become the parameter targets.
+    void synthesize(float* output, int numFrames, int numChannels,
+                    const ModulationInputs& inputs, bool accumulate = false);
+    
     // Parameter setters
     void setFrequency(float frequency);
     void setTenseness(float tenseness);
     void setTonguePosition(float index, float diameter);
     void setConstriction(float index, float diameter, float fricative);
+    // Further articulators in slots 1 to MAX_CONSTRICTIONS - 1, held at the
+    // same time as the one above, which is slot 0: clusters such as "st" or
+    // "pl" need two. Smoothed like the others; an index below 0 frees the slot.
+    void setConstriction(int slot, float index, float diameter, float fricative);
     void setVibrato(float amount, float frequency);
     void setParameterSmoothingTime(float seconds);
     
+    // Stop running the nose waveguide while the velum is closed, see Tract
+    void setNasalBypass(bool enabled) { tract->setNasalBypass(enabled); }
+    
+    // Engine rendering the tract. Every setter and articulation works the
+    // same with both: the tract shape is still computed at control rate, and
+    // the formant engine renders it through a few resonators instead of the
+    // waveguide. Takes effect at the next block boundary, with a short fade
+    // in, and survives restoreState().
+    void setEngine(t_voiceEngine engine) { pendingEngine = engine; }
+    t_voiceEngine getEngine() const { return pendingEngine; }
+    const FormantFilter* getFormantFilter() const { return formantFilter; }
+    
+    // Math quality tier of this voice, see FastMath.h. New voices start at
+    // PINK_TROMBONE_MATH_QUALITY; the fast tier trades exact libm results for
+    // polynomial approximations in the glottal waveform and transients.
+    void setMathQuality(t_mathQuality quality);
+    t_mathQuality getMathQuality() const { return mathQuality; }
+    
+    // Seeds every random source of the voice: the white noise table, the
+    // glottis simplex field and the tract's generator. Voices are seeded from
+    // the clock by default; a voice seeded before it first renders produces
+    // bit-identical output for the same seed and the same calls, at any host
+    // buffer size. The seed is a setting of the voice and survives restoreState(),
+    // which restarts the tract's generator from it.
+    void setSeed(uint32_t seed);
+    uint32_t getSeed() const { return seed; }
+    
+    // Samples between control-rate updates, CONTROL_BLOCK_SIZE by default.
+    // Longer intervals save the per-block work of the glottis, tract reshape
+    // and smoothing at the cost of coarser parameter motion; ramps are scaled
+    // so they keep their speed in time. Takes effect at the next block
+    // boundary and, like the seed, survives restoreState().
+    void setControlInterval(int samples);
+    int getControlInterval() const { return pendingControlInterval; }
+    
+    // RMS of the mix over the last synthesize() call
+    float getLevel() const { return level; }
+    
+    // Area-function articulation, see ArticulationPresets. Replaces the tongue
+    // model until the next setTonguePosition(). The shape is blended and sent
+    // to the tract once per block; the morph amount is smoothed while the pair
+    // of shapes stays the same. Shapes must match the tract length.
+    void setArticulation(t_articulation preset);
+    void setAreaFunction(const t_areaFunction& shape);
+    void morphArticulation(t_articulation from, t_articulation to, float amount);
+    void morphAreaFunctions(const t_areaFunction& from, const t_areaFunction& to, float amount);
+    // Current shape of the tract and velum, e.g. to store as a preset
+    void captureAreaFunction(t_areaFunction& shape);
+    
+    // Output routing
+    void setPan(float pan);                             // -1 (left) to 1 (right), equal power
+    void setOutputBuses(int lipChannel, int noseChannel); // -1 disables a bus
+    
     // Data access for visualization
     float* getTractDiameters();
     float* getNoseDiameters();
     int getTractLength();
     int getNoseLength();
     
+    // Consistent copy of the tract shape as of the last block that changed
+    // it, safe to call from any thread, e.g. to feed a FormantAnalyzer
+    bool getTractShape(t_tractShape& shape) const { return shapeSnapshot.read(shape); }
+    
+    static size_t getArenaSize(int tractLength, t_tractPrecision precision);
+    
+    // Copy the tract waves and shape, glottis phase, filter history and
+    // parameter smoothing state in or out. saveState() only allocates the
+    // first time a given VoiceState is used; restoreState() is a plain copy,
+    // safe on the audio thread, and fails if the state came from a voice with
+    // a different sample rate, tract length or precision.
+    void saveState(VoiceState& state);
+    bool restoreState(const VoiceState& state);
+    
+    // Every control block the voice checks its waveguide and filters for NaN,
+    // infinity or runaway energy, which extreme parameters can cause. A voice
+    // that fails is reset to its recovery state and faded back in over
+    // RECOVERY_FADE_TIME, instead of staying NaN; it keeps its parameters
+    // unless they are not finite themselves. Until then NaN or infinite
+    // output is muted, on the mix and on the buses. The recovery state is
+    // the voice as constructed, or the given snapshot, e.g. a VoiceTemplates
+    // state, which must outlive its use here; null goes back to the default.
+    // Fails if the snapshot is from another kind of voice.
+    bool setRecoveryState(const VoiceState* state);
+    // Resets so far, safe to read from any thread
+    long getRecoveryCount() const { return recoveryCount.load(std::memory_order_relaxed); }
+    
     // Add this method to access the tract directly
     Tract* getTract() { return tract; }
     
+    // Diagnostics pushed from the audio thread, see DiagnosticLogWriter
+    DiagnosticLog* getDiagnosticLog() { return &diagnosticLog; }
+    
+    // Render time and load of each synthesize() call
+    const DspMetrics* getMetrics() const { return &metrics; }
+    
+    // Per-stage render times; null unless built with PINK_TROMBONE_PROFILE
+    Profiler* getProfiler() { return profiler; }
+    const Profiler* getProfiler() const { return profiler; }
+    
 private:
-    void processBlock(float* output, int bufferSize);
+    void render(float* output, int numFrames, int numChannels, bool accumulate,
+                const ModulationInputs* inputs);
+    void applyControlInputs(const ModulationInputs& inputs, int frame);
     
     float sampleRate;
-    float blockTime;
+    float blockTime;                    // duration of one control block
+    int controlInterval;                // samples per control block
+    int pendingControlInterval;
+    float level;
+    
+    VoiceArena arena;
     
     Glottis* glottis;
     Tract* tract;
     WhiteNoise* whiteNoise;
     Biquad* aspirateFilter;
     Biquad* fricativeFilter;
+    FormantFilter* formantFilter;
+    t_voiceEngine engine, pendingEngine;
     
     t_tractProps tractProps;
+    TractShapeSnapshot shapeSnapshot;
+    unsigned int publishedShapeVersion;
+    
+    DiagnosticLog diagnosticLog;
+    uint64_t sampleCount;
+    int controlPosition;                // samples into the current control block
+    t_mathQuality mathQuality;
+    uint32_t seed;
+    int logInterval, logCounter;        // in control blocks
+    
+    DspMetrics metrics;
     
     // Parameter smoothing
     float smoothingTime;
@@ -57,7 +235,48 @@ private:
     float targetConstrictionIndex, currentConstrictionIndex;
     float targetConstrictionDiameter, currentConstrictionDiameter;
     float targetFricative, currentFricative;
+    struct Constriction {
+        float targetIndex, currentIndex;
+        float targetDiameter, currentDiameter;
+        float targetFricative, currentFricative;
+    };
+    Constriction constrictions[MAX_CONSTRICTIONS - 1];  // slots 1 and up
+    
+    // Output routing
+    float pan, panLeft, panRight;
+    int lipChannel, noseChannel;
+    
+    Profiler* profiler;                 // null unless PINK_TROMBONE_PROFILE
+    
+    // Area-function articulation
+    struct Articulation {
+        bool active;
+        float targetMorph, currentMorph;
+        t_areaFunction from, to, shape;
+    };
+    const ArticulationPresets* presets;
+    Articulation articulation;
     
     void updateParameters();
+    void updateAreaFunction();
+    void finishControlBlock();
+    void applyControlInterval();
+    void applyEngine();
     float smoothParameter(float current, float target, float deltaTime);
+    
+    // Health check, see setRecoveryState()
+    bool isStable();
+    void recover();
+    const unsigned char* recoveryState; // in saveState() layout
+    unsigned char* initialState;        // in the arena
+    std::atomic<long> recoveryCount;
+    // After a reset or an engine switch
+    float fadeIn, fadeInStep;
+    
+    size_t getStateSize();
+    static size_t getMaxStateSize(int tractLength, t_tractPrecision precision);
+    void writeState(unsigned char* p);
+    void readState(const unsigned char* p);
+    static float PinkTrombone::* const snapshotParameters[];
+    static const int numSnapshotParameters;
 };
@@ -0,0 +1,187 @@
+//==============================================================================
+// src/QualityGovernor.cpp
+//==============================================================================
+
+#include "QualityGovernor.h"
+
+// Weight of each new block in the smoothed load
+#define LOAD_SMOOTHING  (0.2f)
+
+static const t_qualityTier defaultTiers[] = {
+    { MATH_QUALITY_REFERENCE, false, CONTROL_BLOCK_SIZE, 44, VOICE_ENGINE_WAVEGUIDE },
+    { MATH_QUALITY_REFERENCE, true, CONTROL_BLOCK_SIZE, 44, VOICE_ENGINE_WAVEGUIDE },
+    { MATH_QUALITY_FAST, true, CONTROL_BLOCK_SIZE, 44, VOICE_ENGINE_WAVEGUIDE },
+    { MATH_QUALITY_FAST, true, 2 * CONTROL_BLOCK_SIZE, 44, VOICE_ENGINE_WAVEGUIDE },
+    { MATH_QUALITY_FAST, true, 4 * CONTROL_BLOCK_SIZE, 22, VOICE_ENGINE_WAVEGUIDE },
+    { MATH_QUALITY_FAST, true, 4 * CONTROL_BLOCK_SIZE, 22, VOICE_ENGINE_FORMANT }
+};
+
+QualityGovernor::QualityGovernor(float budget)
+    : budget(budget)
+    , restoreRatio(0.75f)
+    , degradeBlocks(4)
+    , restoreBlocks(200)
+    , settleBlocks(16)
+    , enabled(true)
+    , numTiers(0)
+    , nextIndex(0)
+    , overBlocks(0)
+    , underBlocks(0)
+    , settleCounter(0)
+    , blocks(0)
+    , smoothedLoad(0.0f)
+    , degradeCount(0)
+    , restoreCount(0)
+    , worstTier(0)
+    , decisionCount(0) {
+    voices.reserve(16);
+    for (int i = 0; i < GOVERNOR_MAX_TIERS; i++) tierCounts[i] = 0;
+    for (int i = 0; i < GOVERNOR_HISTORY; i++) history[i].sequence = -1;
+    setTiers(defaultTiers, sizeof(defaultTiers) / sizeof(defaultTiers[0]));
+}
+
+void QualityGovernor::setTiers(const t_qualityTier* tiers, int numTiers) {
+    this->numTiers = std::min(std::max(numTiers, 1), GOVERNOR_MAX_TIERS);
+    for (int i = 0; i < this->numTiers; i++) this->tiers[i] = tiers[i];
+    for (Voice& v : voices) setVoiceTier(v, std::min(v.tier, this->numTiers - 1), getSmoothedLoad());
+}
+
+void QualityGovernor::setHysteresis(int degradeBlocks, int restoreBlocks, int settleBlocks) {
+    this->degradeBlocks = std::max(1, degradeBlocks);
+    this->restoreBlocks = std::max(1, restoreBlocks);
+    this->settleBlocks = std::max(0, settleBlocks);
+}
+
+void QualityGovernor::setEnabled(bool enabled) {
+    this->enabled = enabled;
+    if (!enabled) {
+        for (Voice& v : voices) setVoiceTier(v, 0, getSmoothedLoad());
+    }
+}
+
+void QualityGovernor::addVoice(PinkTrombone* voice) {
+    for (const Voice& v : voices) {
+        if (v.voice == voice) return;
+    }
+    Voice v = { voice, nextIndex++, -1 };
+    voices.push_back(v);
+    setVoiceTier(voices.back(), enabled ? worstTier.load(std::memory_order_relaxed) : 0, getSmoothedLoad());
+}
+
+void QualityGovernor::removeVoice(PinkTrombone* voice) {
+    for (size_t i = 0; i < voices.size(); i++) {
+        if (voices[i].voice != voice) continue;
+        tierCounts[voices[i].tier].fetch_sub(1, std::memory_order_relaxed);
+        voices.erase(voices.begin() + i);
+        updateWorstTier();
+        return;
+    }
+}
+
+int QualityGovernor::getVoiceTier(const PinkTrombone* voice) const {
+    for (const Voice& v : voices) {
+        if (v.voice == voice) return v.tier;
+    }
+    return -1;
+}
+
+void QualityGovernor::beginBlock() {
+    metrics.beginBlock();
+}
+
+void QualityGovernor::endBlock(int numFrames, float sampleRate) {
+    metrics.endBlock(numFrames, sampleRate);
+    blocks++;
+    float load = getSmoothedLoad();
+    load += (metrics.getLoad() - load) * LOAD_SMOOTHING;
+    smoothedLoad.store(load, std::memory_order_relaxed);
+    if (!enabled || voices.empty()) return;
+
+    overBlocks = load > budget ? overBlocks + 1 : 0;
+    underBlocks = load < budget * restoreRatio ? underBlocks + 1 : 0;
+    if (settleCounter > 0) {
+        settleCounter--;
+        return;
+    }
+
+    if (overBlocks >= degradeBlocks) {
+        // Quietest voice that can still drop
+        Voice* pick = nullptr;
+        for (Voice& v : voices) {
+            if (v.tier >= numTiers - 1) continue;
+            if (!pick || v.voice->getLevel() < pick->voice->getLevel()) pick = &v;
+        }
+        if (pick) {
+            setVoiceTier(*pick, pick->tier + 1, load);
+            degradeCount.fetch_add(1, std::memory_order_relaxed);
+            settleCounter = settleBlocks;
+        }
+        overBlocks = 0;
+    } else if (underBlocks >= restoreBlocks) {
+        // Loudest degraded voice
+        Voice* pick = nullptr;
+        for (Voice& v : voices) {
+            if (v.tier <= 0) continue;
+            if (!pick || v.voice->getLevel() > pick->voice->getLevel()) pick = &v;
+        }
+        if (pick) {
+            setVoiceTier(*pick, pick->tier - 1, load);
+            restoreCount.fetch_add(1, std::memory_order_relaxed);
+            settleCounter = settleBlocks;
+        }
+        underBlocks = 0;
+    }
+}
+
+void QualityGovernor::setVoiceTier(Voice& v, int tier, float load) {
+    const t_qualityTier& t = tiers[tier];
+    v.voice->setMathQuality(t.mathQuality);
+    v.voice->setNasalBypass(t.nasalBypass);
+    v.voice->setControlInterval(t.controlInterval);
+    v.voice->setEngine(t.engine);
+    if (tier == v.tier) return;
+
+    if (v.tier >= 0) {
+        tierCounts[v.tier].fetch_sub(1, std::memory_order_relaxed);
+        long sequence = decisionCount.load(std::memory_order_relaxed);
+        DecisionRecord& record = history[sequence & (GOVERNOR_HISTORY - 1)];
+        record.sequence.store(-1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        record.block.store(blocks, std::memory_order_relaxed);
+        record.voice.store(v.index, std::memory_order_relaxed);
+        record.fromTier.store(v.tier, std::memory_order_relaxed);
+        record.toTier.store(tier, std::memory_order_relaxed);
+        record.load.store(load, std::memory_order_relaxed);
+        record.sequence.store(sequence, std::memory_order_release);
+        decisionCount.store(sequence + 1, std::memory_order_release);
+    }
+    tierCounts[tier].fetch_add(1, std::memory_order_relaxed);
+    v.tier = tier;
+    updateWorstTier();
+}
+
+void QualityGovernor::updateWorstTier() {
+    int worst = 0;
+    for (const Voice& v : voices) worst = std::max(worst, v.tier);
+    worstTier.store(worst, std::memory_order_relaxed);
+}
+
+int QualityGovernor::getDecisions(t_governorDecision* decisions, int maxDecisions) const {
+    long count = decisionCount.load(std::memory_order_acquire);
+    long first = std::max(0L, count - std::min(maxDecisions, GOVERNOR_HISTORY));
+    int copied = 0;
+    for (long sequence = first; sequence < count; sequence++) {
+        const DecisionRecord& record = history[sequence & (GOVERNOR_HISTORY - 1)];
+        t_governorDecision d;
+        d.block = record.block.load(std::memory_order_relaxed);
+        d.voice = record.voice.load(std::memory_order_relaxed);
+        d.fromTier = record.fromTier.load(std::memory_order_relaxed);
+        d.toTier = record.toTier.load(std::memory_order_relaxed);
+        d.load = record.load.load(std::memory_order_relaxed);
+        // Skip records the audio thread rewrote while they were read
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (record.sequence.load(std::memory_order_relaxed) != sequence) continue;
+        decisions[copied++] = d;
+    }
+    return copied;
+}
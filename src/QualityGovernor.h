@@ -0,0 +1,118 @@
+//==============================================================================
+// src/QualityGovernor.h - Trades voice quality for render time under load
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include "PinkTrombone.h"
+
+#define GOVERNOR_MAX_TIERS      (8)
+#define GOVERNOR_HISTORY        (64)    // decisions kept for getDecisions(), a power of two
+
+// What a voice runs at one quality tier
+typedef struct t_qualityTier {
+    t_mathQuality mathQuality;
+    bool nasalBypass;
+    int controlInterval;        // samples, see PinkTrombone::setControlInterval()
+    int tractLength;            // for voices created at this tier, see getTractLength()
+    t_voiceEngine engine;
+} t_qualityTier;
+
+typedef struct t_governorDecision {
+    long block;                 // governor block count when it was taken
+    int voice;                  // index in the order voices were added
+    int fromTier, toTier;
+    float load;                 // smoothed load that triggered it, percent
+} t_governorDecision;
+
+// Watches the render time of each block against a budget, in percent of the
+// block's duration, and moves governed voices between quality tiers, tier 0
+// being the best. Above the budget the quietest voice that can still drop
+// does so, one tier per decision; below budget * restoreRatio the loudest
+// degraded voice climbs back. Each condition must hold for a number of blocks
+// and every decision is followed by a pause while its effect shows in the
+// load, so the governor does not oscillate around the budget.
+//
+// The default tiers drop, in order of audibility: exact nasal tract (bypass
+// off), reference math, 64-sample control rate, then 128 and 256-sample
+// control rates, and finally the waveguide for the formant engine. A live
+// voice keeps its tract length; the last two tiers ask for 22-section tracts,
+// which getTractLength() passes on for new voices.
+//
+// Everything but the metrics runs on the audio thread: wrap the render of
+// all governed voices in beginBlock() and endBlock().
+class QualityGovernor {
+public:
+    QualityGovernor(float budget = 70.0f);
+
+    // Audio thread; real-time safe up to setMaxVoices() voices. New voices
+    // enter at the tier of the most degraded voice, or tier 0.
+    void addVoice(PinkTrombone* voice);
+    void removeVoice(PinkTrombone* voice);
+    void setMaxVoices(int maxVoices) { voices.reserve(maxVoices); }
+
+    void beginBlock();
+    void endBlock(int numFrames, float sampleRate);
+
+    // Configuration, not while rendering
+    void setBudget(float percent) { budget = percent; }
+    void setRestoreRatio(float ratio) { restoreRatio = ratio; }
+    // Blocks the load must stay over budget, or under the restore level,
+    // before a decision, and blocks to wait after one
+    void setHysteresis(int degradeBlocks, int restoreBlocks, int settleBlocks);
+    void setTiers(const t_qualityTier* tiers, int numTiers);
+    void setEnabled(bool enabled);      // disabling restores every voice to tier 0
+
+    int getNumTiers() const { return numTiers; }
+    const t_qualityTier& getTier(int tier) const { return tiers[tier]; }
+    int getVoiceTier(const PinkTrombone* voice) const;
+    // Tract length to create new voices with: that of the most degraded tier
+    int getTractLength() const { return tiers[worstTier.load(std::memory_order_relaxed)].tractLength; }
+
+    // Any thread
+    const DspMetrics* getMetrics() const { return &metrics; }
+    float getSmoothedLoad() const { return smoothedLoad.load(std::memory_order_relaxed); }
+    long getDegradeCount() const { return degradeCount.load(std::memory_order_relaxed); }
+    long getRestoreCount() const { return restoreCount.load(std::memory_order_relaxed); }
+    int getVoiceCount(int tier) const { return tierCounts[tier].load(std::memory_order_relaxed); }
+    // Copies up to maxDecisions of the latest decisions, oldest first
+    int getDecisions(t_governorDecision* decisions, int maxDecisions) const;
+
+private:
+    struct Voice {
+        PinkTrombone* voice;
+        int index;
+        int tier;
+    };
+    struct DecisionRecord {
+        std::atomic<long> sequence;
+        std::atomic<long> block;
+        std::atomic<int> voice, fromTier, toTier;
+        std::atomic<float> load;
+    };
+
+    void setVoiceTier(Voice& v, int tier, float load);
+    void updateWorstTier();
+
+    float budget, restoreRatio;
+    int degradeBlocks, restoreBlocks, settleBlocks;
+    bool enabled;
+    t_qualityTier tiers[GOVERNOR_MAX_TIERS];
+    int numTiers;
+
+    // Audio thread
+    std::vector<Voice> voices;
+    int nextIndex;
+    int overBlocks, underBlocks, settleCounter;
+    long blocks;
+    DspMetrics metrics;
+
+    std::atomic<float> smoothedLoad;
+    std::atomic<long> degradeCount, restoreCount;
+    std::atomic<int> tierCounts[GOVERNOR_MAX_TIERS];
+    std::atomic<int> worstTier;
+    std::atomic<long> decisionCount;
+    DecisionRecord history[GOVERNOR_HISTORY];
+};
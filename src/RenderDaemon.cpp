@@ -0,0 +1,523 @@
+//==============================================================================
+// src/RenderDaemon.cpp
+//==============================================================================
+
+#include "RenderDaemon.h"
+#include "ScoreSequencer.h"
+
+#ifndef _WIN32
+
+#include <chrono>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0      // SO_NOSIGPIPE is set on each socket instead
+#endif
+
+// Frames per synthesize() call, so a stop() interrupts long utterances
+static const int renderChunk = 16384;
+
+static double now() {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void ignoreBrokenPipe(int socket) {
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    (void) socket;
+#endif
+}
+
+static bool makeAddress(const std::string& path, sockaddr_un& address) {
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) return false;
+    memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+static bool readFully(int socket, void* data, size_t size) {
+    char* p = (char*) data;
+    while (size > 0) {
+        ssize_t n = recv(socket, p, size, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool writeFully(int socket, const void* data, size_t size) {
+    const char* p = (const char*) data;
+    while (size > 0) {
+        ssize_t n = send(socket, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        p += n;
+        size -= n;
+    }
+    return true;
+}
+
+// Sends the reply with the descriptor attached to its first byte, if any
+static bool sendReply(int socket, const t_renderReply& reply, int descriptor) {
+    iovec data;
+    data.iov_base = (void*) &reply;
+    data.iov_len = sizeof(reply);
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+
+    union {
+        cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    if (descriptor >= 0) {
+        memset(&control, 0, sizeof(control));
+        message.msg_control = control.space;
+        message.msg_controllen = sizeof(control.space);
+        cmsghdr* c = CMSG_FIRSTHDR(&message);
+        c->cmsg_level = SOL_SOCKET;
+        c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c), &descriptor, sizeof(int));
+    }
+
+    ssize_t n;
+    do {
+        n = sendmsg(socket, &message, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    return writeFully(socket, (const char*) &reply + n, sizeof(reply) - n);
+}
+
+// Receives a reply and the descriptor sent with it, or -1
+static bool receiveReply(int socket, t_renderReply& reply, int& descriptor) {
+    descriptor = -1;
+    iovec data;
+    data.iov_base = &reply;
+    data.iov_len = sizeof(reply);
+    msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &data;
+    message.msg_iovlen = 1;
+    union {
+        cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int))];
+    } control;
+    message.msg_control = control.space;
+    message.msg_controllen = sizeof(control.space);
+
+    ssize_t n;
+    do {
+        n = recvmsg(socket, &message, 0);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) return false;
+    for (cmsghdr* c = CMSG_FIRSTHDR(&message); c; c = CMSG_NXTHDR(&message, c)) {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS) {
+            memcpy(&descriptor, CMSG_DATA(c), sizeof(int));
+        }
+    }
+    if (readFully(socket, (char*) &reply + n, sizeof(reply) - n)) return true;
+    if (descriptor >= 0) ::close(descriptor);
+    descriptor = -1;
+    return false;
+}
+
+//==============================================================================
+// RenderDaemon
+//==============================================================================
+
+// One request: its utterances are handed out one at a time, and the
+// connection thread waits on finished until all of them are done
+struct RenderDaemon::Job {
+    const t_renderRequest* request;
+    const Score* score;
+    RenderArchive* archive;
+    uint64_t total;
+    uint64_t next, inFlight, done;  // guarded by the daemon's mutex
+    std::atomic<bool> cancelled;
+    std::condition_variable finished;
+    double started, ended;
+};
+
+// A client and the thread serving it; the thread closes the socket when the
+// client leaves, and the next accepted client reaps it
+struct RenderDaemon::Connection {
+    int socket;
+    std::thread thread;
+    bool finished;
+};
+
+// A worker thread and the voices it keeps warm, one per configuration
+struct RenderDaemon::Worker {
+    struct WarmVoice {
+        Configuration configuration;
+        std::unique_ptr<PinkTrombone> voice;
+        VoiceState fresh;
+    };
+
+    WarmVoice& getVoice(int sampleRate, int tractLength) {
+        for (auto& warm : voices) {
+            if (warm->configuration.sampleRate == sampleRate
+                && warm->configuration.tractLength == tractLength) return *warm;
+        }
+        voices.emplace_back(new WarmVoice);
+        WarmVoice& warm = *voices.back();
+        warm.configuration = { sampleRate, tractLength };
+        warm.voice.reset(new PinkTrombone((float) sampleRate, tractLength));
+        warm.voice->saveState(warm.fresh);
+        return warm;
+    }
+
+    std::thread thread;
+    std::vector<std::unique_ptr<WarmVoice>> voices;
+};
+
+RenderDaemon::RenderDaemon()
+    : threadCount(0)
+    , listener(-1)
+    , running(false)
+    , requestCount(0)
+    , utteranceCount(0) {
+}
+
+RenderDaemon::~RenderDaemon() {
+    stop();
+}
+
+void RenderDaemon::prewarm(int sampleRate, int tractLength) {
+    Configuration configuration = { sampleRate, tractLength };
+    prewarmed.push_back(configuration);
+}
+
+bool RenderDaemon::start(const std::string& socketPath) {
+    if (running) return false;
+    sockaddr_un address;
+    if (!makeAddress(socketPath, address)) return false;
+
+    // A socket file nobody answers on is left over from a daemon that died
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) return false;
+    bool live = ::connect(probe, (const sockaddr*) &address, sizeof(address)) == 0;
+    ::close(probe);
+    if (live) return false;
+    unlink(socketPath.c_str());
+
+    listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) return false;
+    if (bind(listener, (const sockaddr*) &address, sizeof(address)) != 0 || listen(listener, 16) != 0) {
+        ::close(listener);
+        listener = -1;
+        return false;
+    }
+    this->socketPath = socketPath;
+    running = true;
+
+    int threads = threadCount > 0 ? threadCount : (int) std::thread::hardware_concurrency();
+    for (int i = 0; i < std::max(1, threads); i++) {
+        workers.emplace_back(new Worker);
+        workers.back()->thread = std::thread(&RenderDaemon::work, this, workers.back().get());
+    }
+    acceptor = std::thread(&RenderDaemon::acceptConnections, this);
+    return true;
+}
+
+void RenderDaemon::stop() {
+    if (!running.exchange(false)) return;
+
+    // Wakes accept() and every recv() blocked on a client
+    shutdown(listener, SHUT_RDWR);
+    acceptor.join();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& connection : connections) {
+            if (connection->socket >= 0) shutdown(connection->socket, SHUT_RDWR);
+        }
+        // Jobs with an utterance in flight are woken by the worker
+        for (Job* job : jobs) {
+            job->cancelled = true;
+            if (job->inFlight == 0) job->finished.notify_all();
+        }
+        jobs.clear();
+    }
+    taskAvailable.notify_all();
+    for (auto& worker : workers) worker->thread.join();
+    workers.clear();
+    for (auto& connection : connections) connection->thread.join();
+    connections.clear();
+
+    ::close(listener);
+    listener = -1;
+    unlink(socketPath.c_str());
+}
+
+void RenderDaemon::acceptConnections() {
+    while (running) {
+        int socket = accept(listener, nullptr, nullptr);
+        if (socket < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            break;
+        }
+        ignoreBrokenPipe(socket);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!running) {
+            ::close(socket);
+            break;
+        }
+        for (size_t i = 0; i < connections.size(); ) {
+            if (connections[i]->finished) {
+                connections[i]->thread.join();
+                connections.erase(connections.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        connections.emplace_back(new Connection);
+        Connection* connection = connections.back().get();
+        connection->socket = socket;
+        connection->finished = false;
+        connection->thread = std::thread(&RenderDaemon::serve, this, connection);
+    }
+}
+
+void RenderDaemon::serve(Connection* client) {
+    int connection = client->socket;
+    // Score images are read into 8-byte words so keyframes are aligned
+    std::vector<uint64_t> scoreData;
+    t_renderRequest request;
+    while (running && readFully(connection, &request, sizeof(request))) {
+        requestCount++;
+        t_renderReply reply;
+        memset(&reply, 0, sizeof(reply));
+        reply.magic = RENDER_REPLY_MAGIC;
+
+        bool valid = request.magic == RENDER_REQUEST_MAGIC
+            && request.version == RENDER_PROTOCOL_VERSION
+            && (request.tractLength == 44 || request.tractLength == 22)
+            && (request.mathQuality == MATH_QUALITY_REFERENCE || request.mathQuality == MATH_QUALITY_FAST)
+            && request.tailSeconds >= 0.0f && request.tailSeconds <= 60.0f
+            && request.scoreSize <= RENDER_MAX_SCORE_SIZE;
+        if (!valid) {
+            // The stream cannot be trusted past a bad header
+            reply.status = RENDER_STATUS_BAD_REQUEST;
+            sendReply(connection, reply, -1);
+            break;
+        }
+
+        scoreData.resize((size_t) (request.scoreSize + 7) / 8);
+        if (!readFully(connection, scoreData.data(), (size_t) request.scoreSize)) break;
+
+        // load() checks every table of the image against the bytes received
+        // before anything reads it, as clients are not trusted
+        Score score;
+        RenderArchive archive;
+        if (!score.load(scoreData.data(), (size_t) request.scoreSize)
+            || score.getSampleRate() < 8000 || score.getSampleRate() > 192000
+            || score.getLength() > (uint64_t) RENDER_MAX_SECONDS * score.getSampleRate()) {
+            reply.status = RENDER_STATUS_BAD_SCORE;
+        } else {
+            reply.status = submit(request, score, archive, reply);
+        }
+        bool ok = reply.status == RENDER_STATUS_OK;
+        if (ok) reply.archiveSize = archive.getByteSize();
+        if (!sendReply(connection, reply, ok ? archive.getDescriptor() : -1)) break;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ::close(connection);
+    client->socket = -1;
+    client->finished = true;
+}
+
+t_renderStatus RenderDaemon::submit(const t_renderRequest& request, const Score& score,
+                                    RenderArchive& archive, t_renderReply& reply) {
+    double received = now();
+    int sampleRate = score.getSampleRate();
+    uint64_t total = score.getVoiceCount();
+    uint64_t tail = (uint64_t) (request.tailSeconds * sampleRate);
+    std::vector<uint64_t> frameCounts(total);
+    for (uint64_t i = 0; i < total; i++) {
+        uint64_t count = score.getKeyframeCount((int) i);
+        frameCounts[i] = (count > 0 ? score.getKeyframes((int) i)[count - 1].sampleTime : 0) + tail;
+    }
+    if (!archive.createShared(sampleRate, 1, frameCounts)) return RENDER_STATUS_NO_MEMORY;
+    if (total == 0) return RENDER_STATUS_OK;
+
+    Job job;
+    job.request = &request;
+    job.score = &score;
+    job.archive = &archive;
+    job.total = total;
+    job.next = job.inFlight = job.done = 0;
+    job.cancelled = false;
+    job.started = job.ended = received;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!running) return RENDER_STATUS_SHUTDOWN;
+    jobs.push_back(&job);
+    taskAvailable.notify_all();
+    job.finished.wait(lock, [&] {
+        return job.done == job.total || (job.cancelled && job.inFlight == 0);
+    });
+    // A cancelled job may still be queued if stop() has not reached it yet
+    for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+        if (*it == &job) {
+            jobs.erase(it);
+            break;
+        }
+    }
+    if (job.done < job.total) return RENDER_STATUS_SHUTDOWN;
+
+    reply.queueSeconds = job.started - received;
+    reply.renderSeconds = job.ended - job.started;
+    return RENDER_STATUS_OK;
+}
+
+bool RenderDaemon::nextTask(Job*& job, uint64_t& utterance) {
+    std::unique_lock<std::mutex> lock(mutex);
+    taskAvailable.wait(lock, [this] { return !jobs.empty() || !running; });
+    if (!running) return false;
+
+    // Round-robin: the job goes to the back of the queue after each utterance
+    job = jobs.front();
+    jobs.pop_front();
+    if (job->next == 0) job->started = now();
+    utterance = job->next++;
+    job->inFlight++;
+    if (job->next < job->total) jobs.push_back(job);
+    return true;
+}
+
+void RenderDaemon::finishTask(Job* job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    job->inFlight--;
+    if (!job->cancelled) job->done++;
+    if (job->done == job->total) job->ended = now();
+    if (job->done == job->total || (job->cancelled && job->inFlight == 0)) job->finished.notify_all();
+}
+
+void RenderDaemon::work(Worker* worker) {
+    for (const Configuration& c : prewarmed) worker->getVoice(c.sampleRate, c.tractLength);
+
+    Job* job;
+    uint64_t i;
+    while (nextTask(job, i)) {
+        const t_renderRequest& request = *job->request;
+        Worker::WarmVoice& warm = worker->getVoice(job->score->getSampleRate(), request.tractLength);
+        PinkTrombone& voice = *warm.voice;
+        voice.restoreState(warm.fresh);
+        voice.setMathQuality((t_mathQuality) request.mathQuality);
+        voice.setSeed(request.seed + (uint32_t) i);
+        ScoreSequencer sequencer(*job->score, (int) i);
+
+        float* output = job->archive->getWritableSamples(i);
+        uint64_t frames = job->archive->getFrameCount(i);
+        for (uint64_t done = 0; done < frames; ) {
+            if (!running) {
+                job->cancelled = true;
+                break;
+            }
+            int chunk = (int) std::min<uint64_t>(renderChunk, frames - done);
+            sequencer.render(voice, output + done, chunk);
+            done += chunk;
+        }
+        utteranceCount++;
+        finishTask(job);
+    }
+}
+
+//==============================================================================
+// RenderClient
+//==============================================================================
+
+RenderClient::RenderClient() : socket(-1) {
+}
+
+RenderClient::~RenderClient() {
+    disconnect();
+}
+
+bool RenderClient::connect(const std::string& socketPath) {
+    disconnect();
+    sockaddr_un address;
+    if (!makeAddress(socketPath, address)) return false;
+    socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket < 0) return false;
+    ignoreBrokenPipe(socket);
+    if (::connect(socket, (const sockaddr*) &address, sizeof(address)) != 0) {
+        disconnect();
+        return false;
+    }
+    return true;
+}
+
+void RenderClient::disconnect() {
+    if (socket >= 0) ::close(socket);
+    socket = -1;
+}
+
+t_renderStatus RenderClient::render(const void* score, size_t scoreSize, const t_renderOptions& options,
+                                    RenderArchive& archive, t_renderReply* reply) {
+    archive.close();
+    if (socket < 0) return RENDER_STATUS_DISCONNECTED;
+
+    t_renderRequest request;
+    memset(&request, 0, sizeof(request));
+    request.magic = RENDER_REQUEST_MAGIC;
+    request.version = RENDER_PROTOCOL_VERSION;
+    request.seed = options.seed;
+    request.tractLength = options.tractLength;
+    request.mathQuality = options.mathQuality;
+    request.tailSeconds = options.tailSeconds;
+    request.scoreSize = scoreSize;
+
+    t_renderReply received;
+    int descriptor;
+    if (!writeFully(socket, &request, sizeof(request)) || !writeFully(socket, score, scoreSize)
+        || !receiveReply(socket, received, descriptor) || received.magic != RENDER_REPLY_MAGIC) {
+        disconnect();
+        return RENDER_STATUS_DISCONNECTED;
+    }
+    if (reply) *reply = received;
+
+    t_renderStatus status = (t_renderStatus) received.status;
+    if (status == RENDER_STATUS_BAD_REQUEST) disconnect();  // the daemon hung up
+    if (status != RENDER_STATUS_OK) {
+        if (descriptor >= 0) ::close(descriptor);
+        return status;
+    }
+    if (descriptor < 0 || !archive.open(descriptor)) return RENDER_STATUS_NO_MEMORY;
+    return RENDER_STATUS_OK;
+}
+
+#else
+
+struct RenderDaemon::Job {};
+struct RenderDaemon::Worker {};
+struct RenderDaemon::Connection {};
+
+RenderDaemon::RenderDaemon() : threadCount(0), listener(-1), running(false), requestCount(0), utteranceCount(0) {}
+RenderDaemon::~RenderDaemon() {}
+void RenderDaemon::prewarm(int sampleRate, int tractLength) {}
+bool RenderDaemon::start(const std::string& socketPath) { return false; }
+void RenderDaemon::stop() {}
+
+RenderClient::RenderClient() : socket(-1) {}
+RenderClient::~RenderClient() {}
+bool RenderClient::connect(const std::string& socketPath) { return false; }
+void RenderClient::disconnect() {}
+t_renderStatus RenderClient::render(const void* score, size_t scoreSize, const t_renderOptions& options,
+                                    RenderArchive& archive, t_renderReply* reply) {
+    return RENDER_STATUS_DISCONNECTED;
+}
+
+#endif
@@ -0,0 +1,152 @@
+//==============================================================================
+// src/RenderDaemon.h - Long-running render service on a Unix domain socket
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "PinkTrombone.h"
+#include "core/RenderArchive.h"
+#include "core/Score.h"
+
+#define RENDER_REQUEST_MAGIC    (0x51525450)    // "PTRQ", little-endian
+#define RENDER_REPLY_MAGIC      (0x50525450)    // "PTRP"
+#define RENDER_PROTOCOL_VERSION (1)
+#define RENDER_MAX_SCORE_SIZE   (256u << 20)    // bytes
+
+// Wire format, native byte order (both ends are on the same machine). A
+// client sends a t_renderRequest followed by scoreSize bytes of score file
+// (see Score.h), and gets back a t_renderReply. When the status is
+// RENDER_STATUS_OK the reply carries one descriptor (SCM_RIGHTS) of shared
+// memory holding a RenderArchive with one mono utterance per score voice,
+// which the client maps with RenderArchive::open(descriptor). A connection
+// can carry any number of requests, one at a time.
+typedef struct t_renderRequest {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t seed;              // utterance i is seeded with seed + i
+    int32_t tractLength;        // 44 or 22
+    int32_t mathQuality;        // t_mathQuality
+    float tailSeconds;          // rendered past each voice's last keyframe
+    uint64_t scoreSize;
+} t_renderRequest;
+
+typedef enum t_renderStatus {
+    RENDER_STATUS_OK,
+    RENDER_STATUS_BAD_REQUEST,
+    RENDER_STATUS_BAD_SCORE,    // unreadable, or longer than RENDER_MAX_SECONDS
+    RENDER_STATUS_NO_MEMORY,
+    RENDER_STATUS_SHUTDOWN,
+    RENDER_STATUS_DISCONNECTED  // client side only
+} t_renderStatus;
+
+typedef struct t_renderReply {
+    uint32_t magic;
+    int32_t status;             // t_renderStatus
+    uint64_t archiveSize;       // bytes
+    double queueSeconds;        // from receipt to the first utterance starting
+    double renderSeconds;       // from then to the last one finishing
+} t_renderReply;
+
+static_assert(sizeof(t_renderRequest) == 32, "render request layout");
+static_assert(sizeof(t_renderReply) == 32, "render reply layout");
+
+// Renders scores for any number of local clients on one set of worker
+// threads. Each worker keeps a voice, and a fresh-state snapshot to reset it
+// with, for every sample rate and tract length it has seen, so voice
+// construction is paid once per daemon rather than per request; prewarm()
+// pays it before the first request. The utterances of all pending requests
+// share one queue, taken round-robin between requests, so a short preview
+// is not stuck behind a long batch. Results are written straight into
+// shared memory and handed over by descriptor, without copies.
+//
+// Each connection gets a thread that reads its requests and writes replies.
+// POSIX only; start() fails elsewhere.
+class RenderDaemon {
+public:
+    RenderDaemon();
+    ~RenderDaemon();
+
+    // Configuration, before start()
+    void setThreadCount(int threads) { threadCount = threads; }    // 0 uses every core
+    // Has every worker build a voice for this configuration as it starts
+    void prewarm(int sampleRate, int tractLength = 44);
+
+    // Binds the socket, replacing a stale socket file at that path, and
+    // starts the workers; returns false if the socket cannot be bound
+    bool start(const std::string& socketPath);
+    // Fails pending requests with RENDER_STATUS_SHUTDOWN, closes every
+    // connection and removes the socket file
+    void stop();
+    bool isRunning() const { return running; }
+
+    uint64_t getRequestCount() const { return requestCount.load(); }
+    uint64_t getUtteranceCount() const { return utteranceCount.load(); }
+
+private:
+    struct Job;
+    struct Worker;
+    struct Connection;
+    struct Configuration {
+        int sampleRate, tractLength;
+    };
+
+    void acceptConnections();
+    void serve(Connection* connection);
+    void work(Worker* worker);
+    bool nextTask(Job*& job, uint64_t& utterance);
+    void finishTask(Job* job);
+    t_renderStatus submit(const t_renderRequest& request, const Score& score,
+                          RenderArchive& archive, t_renderReply& reply);
+
+    int threadCount;
+    std::vector<Configuration> prewarmed;
+    std::string socketPath;
+    int listener;
+    std::atomic<bool> running;
+    std::thread acceptor;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex mutex;                       // guards everything below
+    std::condition_variable taskAvailable;
+    std::deque<Job*> jobs;                  // with utterances left to start
+    std::vector<std::unique_ptr<Connection>> connections;
+
+    std::atomic<uint64_t> requestCount, utteranceCount;
+};
+
+typedef struct t_renderOptions {
+    uint32_t seed = 0;
+    int tractLength = 44;
+    t_mathQuality mathQuality = PINK_TROMBONE_MATH_QUALITY;
+    float tailSeconds = 0.5f;
+} t_renderOptions;
+
+// Blocking client for a RenderDaemon
+class RenderClient {
+public:
+    RenderClient();
+    ~RenderClient();
+
+    bool connect(const std::string& socketPath);
+    void disconnect();
+    bool isConnected() const { return socket >= 0; }
+
+    // Sends a score image (the bytes of a score file) and waits for the
+    // result, which archive then maps read-only. reply, when given, receives
+    // the daemon's timings.
+    t_renderStatus render(const void* score, size_t scoreSize, const t_renderOptions& options,
+                          RenderArchive& archive, t_renderReply* reply = nullptr);
+
+private:
+    RenderClient(const RenderClient&) = delete;
+    RenderClient& operator=(const RenderClient&) = delete;
+
+    int socket;
+};
@@ -0,0 +1,59 @@
+//==============================================================================
+// src/ScoreSequencer.cpp
+//==============================================================================
+
+#include "ScoreSequencer.h"
+
+ScoreSequencer::ScoreSequencer(const Score& score, int voice, int controlInterval)
+    : keyframes(score.getKeyframes(voice))
+    , count(score.getKeyframeCount(voice))
+    , cursor(0)
+    , position(0)
+    , controlInterval(std::max(1, controlInterval)) {
+}
+
+void ScoreSequencer::apply(PinkTrombone& voice, const t_scoreKeyframe& keyframe) {
+    if (keyframe.flags & SCORE_FREQUENCY) voice.setFrequency(keyframe.frequency);
+    if (keyframe.flags & SCORE_TENSENESS) voice.setTenseness(keyframe.tenseness);
+    if (keyframe.flags & SCORE_TONGUE) voice.setTonguePosition(keyframe.tongueIndex, keyframe.tongueDiameter);
+    if (keyframe.flags & SCORE_CONSTRICTION) {
+        voice.setConstriction(keyframe.constrictionIndex, keyframe.constrictionDiameter, keyframe.fricative);
+    }
+}
+
+void ScoreSequencer::seek(PinkTrombone& voice, uint64_t sampleTime) {
+    // First keyframe at or after sampleTime
+    const t_scoreKeyframe* end = std::lower_bound(keyframes, keyframes + count, sampleTime,
+        [](const t_scoreKeyframe& k, uint64_t t) { return k.sampleTime < t; });
+    cursor = end - keyframes;
+    position = sampleTime;
+
+    // Latest value of each parameter group before the seek point
+    uint32_t pending = SCORE_FREQUENCY | SCORE_TENSENESS | SCORE_TONGUE | SCORE_CONSTRICTION;
+    for (const t_scoreKeyframe* k = end; k != keyframes && pending; ) {
+        --k;
+        t_scoreKeyframe partial = *k;
+        partial.flags &= pending;
+        apply(voice, partial);
+        pending &= ~k->flags;
+    }
+}
+
+void ScoreSequencer::advance(PinkTrombone& voice, uint64_t sampleTime) {
+    while (cursor < count && keyframes[cursor].sampleTime < sampleTime) {
+        apply(voice, keyframes[cursor++]);
+    }
+    position = std::max(position, sampleTime);
+}
+
+void ScoreSequencer::render(PinkTrombone& voice, float* output, int numFrames, int numChannels, bool accumulate) {
+    int done = 0;
+    while (done < numFrames) {
+        // Slice up to the next control-rate boundary
+        int slice = controlInterval - (int) (position % controlInterval);
+        slice = std::min(slice, numFrames - done);
+        advance(voice, position + slice);
+        voice.synthesize(output + done * numChannels, slice, numChannels, accumulate);
+        done += slice;
+    }
+}
@@ -0,0 +1,43 @@
+//==============================================================================
+// src/ScoreSequencer.h - Plays one voice of a Score into a PinkTrombone
+//==============================================================================
+
+#pragma once
+
+#include "PinkTrombone.h"
+#include "core/Score.h"
+
+// Walks a voice's keyframes with a cursor and applies them at control rate:
+// render() splits the block at every controlInterval samples and applies the
+// keyframes due before each slice, so a keyframe lands at most one interval
+// early. Nothing is parsed or allocated; keyframes are read straight from the
+// mapped score, which must outlive the sequencer. The voice is expected to run
+// at the score's sample rate.
+class ScoreSequencer {
+public:
+    ScoreSequencer(const Score& score, int voice, int controlInterval = CONTROL_BLOCK_SIZE);
+
+    // Moves the cursor to sampleTime and applies the latest keyframe of each
+    // parameter group before it, so playback can start mid-score
+    void seek(PinkTrombone& voice, uint64_t sampleTime);
+
+    // Applies keyframes up to (but not including) sampleTime and advances the
+    // cursor, for hosts that drive synthesize() themselves
+    void advance(PinkTrombone& voice, uint64_t sampleTime);
+
+    // Renders numFrames at the current position, see PinkTrombone::synthesize()
+    void render(PinkTrombone& voice, float* output, int numFrames,
+                int numChannels = 1, bool accumulate = false);
+
+    uint64_t getPosition() const { return position; }
+    bool isFinished() const { return cursor >= count; }
+
+private:
+    static void apply(PinkTrombone& voice, const t_scoreKeyframe& keyframe);
+
+    const t_scoreKeyframe* keyframes;
+    uint64_t count;
+    uint64_t cursor;
+    uint64_t position;
+    int controlInterval;
+};
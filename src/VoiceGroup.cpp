@@ -0,0 +1,69 @@
+//==============================================================================
+// src/VoiceGroup.cpp
+//==============================================================================
+
+#include "VoiceGroup.h"
+
+VoiceGroup::VoiceGroup(int internalRate, int hostRate, int numChannels, int maxHostFrames, int taps)
+    : internalRate(internalRate)
+    , hostRate(hostRate)
+    , numChannels(std::max(1, numChannels))
+    , maxHostFrames(std::max(1, maxHostFrames)) {
+    voices.reserve(16);
+    if (internalRate != hostRate) {
+        // Input needed for the longest block, plus what the phase carries over
+        int maxInputFrames = (int) ((long long) (this->maxHostFrames + 1) * internalRate / hostRate) + 3;
+        if (resampler.setup(internalRate, hostRate, this->numChannels, maxInputFrames, taps)) {
+            mix.resize((size_t) maxInputFrames * this->numChannels);
+            converted.resize((size_t) this->maxHostFrames * this->numChannels);
+        } else {
+            ofLogWarning("VoiceGroup") << "cannot resample " << internalRate << " Hz to " << hostRate
+                                       << " Hz, rendering at the host rate";
+            this->internalRate = hostRate;
+        }
+    }
+}
+
+void VoiceGroup::addVoice(PinkTrombone* voice) {
+    if (std::find(voices.begin(), voices.end(), voice) == voices.end()) voices.push_back(voice);
+}
+
+void VoiceGroup::removeVoice(PinkTrombone* voice) {
+    voices.erase(std::remove(voices.begin(), voices.end(), voice), voices.end());
+}
+
+void VoiceGroup::render(float* output, int numFrames, int numChannels, bool accumulate) {
+    if (!resampler.isSetup()) {
+        if (!accumulate) memset(output, 0, (size_t) numFrames * numChannels * sizeof(float));
+        for (PinkTrombone* voice : voices) voice->synthesize(output, numFrames, numChannels, true);
+        return;
+    }
+
+    // Voices render with the output's channel layout, up to the group's
+    // channel count; wider outputs take those through a scratch buffer
+    int channels = std::min(numChannels, this->numChannels);
+    while (numFrames > 0) {
+        int frames = std::min(numFrames, maxHostFrames);
+        int inputFrames = resampler.getInputFrames(frames);
+        std::fill(mix.begin(), mix.begin() + (size_t) inputFrames * channels, 0.0f);
+        for (PinkTrombone* voice : voices) voice->synthesize(mix.data(), inputFrames, channels, true);
+
+        if (channels == numChannels) {
+            resampler.process(mix.data(), inputFrames, channels, output, frames, accumulate);
+        } else {
+            resampler.process(mix.data(), inputFrames, channels, converted.data(), frames);
+            if (!accumulate) memset(output, 0, (size_t) frames * numChannels * sizeof(float));
+            for (int i = 0; i < frames; i++) {
+                const float* in = &converted[(size_t) i * channels];
+                float* out = output + (size_t) i * numChannels;
+                for (int ch = 0; ch < channels; ch++) out[ch] += in[ch];
+            }
+        }
+        output += (size_t) frames * numChannels;
+        numFrames -= frames;
+    }
+}
+
+float VoiceGroup::getLatency() const {
+    return resampler.isSetup() ? resampler.getLatency() * (float) hostRate / internalRate : 0.0f;
+}
@@ -0,0 +1,45 @@
+//==============================================================================
+// src/VoiceGroup.h - Voices rendered at a fixed internal rate, resampled once
+//==============================================================================
+
+#pragma once
+
+#include <vector>
+#include "PinkTrombone.h"
+#include "core/Resampler.h"
+
+// Mixes its voices at internalRate and converts the mix to the host rate with
+// one Resampler, so the tract keeps the same timbre and cost at any host rate
+// and the conversion is paid per group rather than per voice. Voices must be
+// created at getInternalRate(). When the two rates match the voices render
+// straight into the output.
+class VoiceGroup {
+public:
+    VoiceGroup(int internalRate, int hostRate, int numChannels = 2,
+               int maxHostFrames = 4096, int taps = RESAMPLER_DEFAULT_TAPS);
+
+    // Real-time safe up to maxVoices voices; the group does not own them
+    void addVoice(PinkTrombone* voice);
+    void removeVoice(PinkTrombone* voice);
+    void setMaxVoices(int maxVoices) { voices.reserve(maxVoices); }
+
+    // Voices are mixed with the output's channel layout; channels beyond the
+    // group's count are left silent. The channel count should not change from
+    // call to call. Long buffers are split.
+    void render(float* output, int numFrames, int numChannels, bool accumulate = false);
+
+    int getInternalRate() const { return internalRate; }
+    int getHostRate() const { return hostRate; }
+    bool isResampling() const { return resampler.isSetup(); }
+    // Delay added by the resampler, in host frames
+    float getLatency() const;
+
+private:
+    int internalRate, hostRate;
+    int numChannels;
+    int maxHostFrames;
+    std::vector<PinkTrombone*> voices;
+    Resampler resampler;
+    std::vector<float> mix;             // internal rate
+    std::vector<float> converted;       // host rate, for narrower outputs
+};
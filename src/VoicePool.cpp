@@ -0,0 +1,49 @@
+//==============================================================================
+// src/VoicePool.cpp
+//==============================================================================
+
+#include "VoicePool.h"
+
+VoicePool::VoicePool(int capacity, int tractLength, t_tractPrecision precision)
+    : capacity(capacity)
+    , tractLength(tractLength)
+    , precision(precision)
+    , voiceSize(VoiceArena::align(sizeof(PinkTrombone)))
+    , slotUsed(new std::atomic<bool>[capacity])
+    , activeCount(0) {
+    slotSize = voiceSize + VoiceArena::align(PinkTrombone::getArenaSize(tractLength, precision));
+    memory = static_cast<char*>(VoiceArena::allocateAligned(slotSize * capacity));
+    for (int i = 0; i < capacity; i++) slotUsed[i] = false;
+    
+    // Voices share the default presets, which are built on first use
+    ArticulationPresets::getDefault(tractLength);
+}
+
+VoicePool::~VoicePool() {
+    for (int i = 0; i < capacity; i++) {
+        if (slotUsed[i]) reinterpret_cast<PinkTrombone*>(memory + i * slotSize)->~PinkTrombone();
+    }
+    VoiceArena::freeAligned(memory);
+}
+
+PinkTrombone* VoicePool::createVoice(float sampleRate) {
+    for (int i = 0; i < capacity; i++) {
+        bool expected = false;
+        if (!slotUsed[i].compare_exchange_strong(expected, true, std::memory_order_acquire)) continue;
+        
+        char* slot = memory + i * slotSize;
+        activeCount.fetch_add(1, std::memory_order_relaxed);
+        return new (slot) PinkTrombone(sampleRate, tractLength, precision, slot + voiceSize);
+    }
+    return nullptr;
+}
+
+void VoicePool::destroyVoice(PinkTrombone* voice) {
+    if (!voice) return;
+    int i = (int) ((reinterpret_cast<char*>(voice) - memory) / slotSize);
+    if (i < 0 || i >= capacity) return;
+    
+    voice->~PinkTrombone();
+    activeCount.fetch_sub(1, std::memory_order_relaxed);
+    slotUsed[i].store(false, std::memory_order_release);
+}
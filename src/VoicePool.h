@@ -0,0 +1,40 @@
+//==============================================================================
+// src/VoicePool.h - Preallocated storage for PinkTrombone voices
+//==============================================================================
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include "PinkTrombone.h"
+
+// Fixed number of slots, each holding a PinkTrombone followed by its arena.
+// The shared ArticulationPresets are built here too, so createVoice() and
+// destroyVoice() never allocate or lock and voices can be spawned from the
+// audio thread. Voices constructed on their own still allocate their arena,
+// and the first one builds the presets.
+class VoicePool {
+public:
+    VoicePool(int capacity, int tractLength = 44,
+              t_tractPrecision precision = TRACT_PRECISION_FLOAT);
+    ~VoicePool();
+    
+    // Returns nullptr when every slot is taken
+    PinkTrombone* createVoice(float sampleRate);
+    void destroyVoice(PinkTrombone* voice);
+    
+    int getCapacity() const { return capacity; }
+    int getActiveCount() const { return activeCount.load(std::memory_order_relaxed); }
+    
+private:
+    VoicePool(const VoicePool&) = delete;
+    VoicePool& operator=(const VoicePool&) = delete;
+    
+    int capacity;
+    int tractLength;
+    t_tractPrecision precision;
+    size_t voiceSize, slotSize;
+    char* memory;
+    std::unique_ptr<std::atomic<bool>[]> slotUsed;
+    std::atomic<int> activeCount;
+};
@@ -0,0 +1,29 @@
+//==============================================================================
+// src/VoiceTemplates.cpp
+//==============================================================================
+
+#include "VoiceTemplates.h"
+
+static_assert((int) VOWEL_U == (int) ARTICULATION_U, "Vowels are the first articulation presets");
+
+void VoiceTemplates::getTonguePosition(t_vowel vowel, float& index, float& diameter) {
+    ArticulationPresets::getTonguePosition((t_articulation) vowel, index, diameter);
+}
+
+void VoiceTemplates::prewarm(float sampleRate, int tractLength, t_tractPrecision precision,
+                             float warmupSeconds, float frequency, float tenseness) {
+    const int blockSize = 512;
+    float buffer[blockSize];
+    int numBlocks = (int) ceil(warmupSeconds * sampleRate / blockSize);
+    
+    for (int v = 0; v < NUM_VOWELS; v++) {
+        PinkTrombone voice(sampleRate, tractLength, precision);
+        voice.setFrequency(frequency);
+        voice.setTenseness(tenseness);
+        voice.setArticulation((t_articulation) v);
+        for (int i = 0; i < numBlocks; i++) {
+            voice.synthesize(buffer, blockSize);
+        }
+        voice.saveState(states[v]);
+    }
+}
@@ -0,0 +1,39 @@
+//==============================================================================
+// src/VoiceTemplates.h - Prewarmed voice states to start new notes from
+//==============================================================================
+
+#pragma once
+
+#include "PinkTrombone.h"
+
+typedef enum t_vowel {
+    VOWEL_A,
+    VOWEL_E,
+    VOWEL_I,
+    VOWEL_O,
+    VOWEL_U,
+    NUM_VOWELS
+} t_vowel;
+
+// One snapshot per vowel, taken after rendering a voice long enough for the
+// glottis intensity ramp and the waveguide to settle. Restoring a template
+// into a fresh voice starts it in that steady state instead of from silence.
+class VoiceTemplates {
+public:
+    // Offline work: renders warmupSeconds of audio per vowel
+    void prewarm(float sampleRate, int tractLength = 44,
+                 t_tractPrecision precision = TRACT_PRECISION_FLOAT,
+                 float warmupSeconds = 0.5f,
+                 float frequency = 140.0f, float tenseness = 0.6f);
+    
+    bool isReady() const { return states[0].isValid(); }
+    const VoiceState& get(t_vowel vowel) const { return states[vowel]; }
+    
+    // Real-time safe
+    bool apply(PinkTrombone& voice, t_vowel vowel) const { return voice.restoreState(states[vowel]); }
+    
+    static void getTonguePosition(t_vowel vowel, float& index, float& diameter);
+    
+private:
+    VoiceState states[NUM_VOWELS];
+};
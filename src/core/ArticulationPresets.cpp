@@ -0,0 +1,108 @@
+//==============================================================================
+// src/core/ArticulationPresets.cpp
+//==============================================================================
+
+#include "ArticulationPresets.h"
+#include "Tract.h"
+#include "util.h"
+
+typedef struct t_articulationSpec {
+    sample_t tongueIndex;
+    sample_t tongueDiameter;
+    sample_t constrictionIndex;     // -1 for none
+    sample_t constrictionDiameter;
+    sample_t velum;                 // vowels: at least, the tongue model may open it further
+} t_articulationSpec;
+
+#define VELUM_CLOSED (0.01)
+#define VELUM_OPEN (0.4)
+
+// Indices are for the 44-section tract and scaled to the built length
+static const t_articulationSpec specs[NUM_ARTICULATIONS] = {
+    { 12.9, 2.43, -1.0, 1.0, VELUM_CLOSED },    // A
+    { 21.0, 2.36, -1.0, 1.0, VELUM_CLOSED },    // E
+    { 25.0, 2.05, -1.0, 1.0, VELUM_CLOSED },    // I
+    { 14.0, 2.7,  -1.0, 1.0, VELUM_CLOSED },    // O
+    { 16.0, 2.8,  -1.0, 1.0, VELUM_CLOSED },    // U
+    { 12.9, 2.43, 41.0, 0.0, VELUM_OPEN },      // M
+    { 12.9, 2.43, 36.0, 0.0, VELUM_OPEN },      // N
+    { 12.9, 2.43, 24.0, 0.0, VELUM_OPEN },      // NG
+    { 12.9, 2.43, 41.0, 0.0, VELUM_CLOSED },    // B
+    { 12.9, 2.43, 36.0, 0.0, VELUM_CLOSED },    // D
+    { 12.9, 2.43, 24.0, 0.0, VELUM_CLOSED },    // G
+    { 12.9, 2.43, 41.0, 0.7, VELUM_CLOSED },    // F
+    { 21.0, 2.36, 36.0, 0.6, VELUM_CLOSED },    // S
+    { 21.0, 2.36, 33.0, 0.75, VELUM_CLOSED }    // SH
+};
+
+void blendAreaFunctions(const t_areaFunction &a, const t_areaFunction &b, sample_t amount, t_areaFunction &out)
+{
+    out.n = a.n;
+    out.velum = a.velum + (b.velum - a.velum) * amount;
+    for (int i = 0; i < a.n; i++) {
+        out.diameter[i] = a.diameter[i] + (b.diameter[i] - a.diameter[i]) * amount;
+    }
+}
+
+ArticulationPresets::ArticulationPresets()
+{
+    for (int i = 0; i < NUM_ARTICULATIONS; i++) this->presets[i].n = 0;
+}
+
+void ArticulationPresets::build(int tractLength)
+{
+    sample_t tractDiameter[AREA_FUNCTION_MAX_LENGTH];
+    sample_t noseDiameter[AREA_FUNCTION_MAX_LENGTH];
+    t_tractProps props;
+    initializeTractProps(&props, tractLength, tractDiameter, noseDiameter);
+
+    // With a one second block, a single finishBlock() moves every section
+    // all the way to its constricted target
+    Tract *tract = Tract::create(44100, 1.0, &props);
+    if (!tract) return;
+
+    sample_t scale = (sample_t) tractLength / NUM_CONSTRICTIONS;
+    for (int i = 0; i < NUM_ARTICULATIONS; i++) {
+        const t_articulationSpec &spec = specs[i];
+        // Vowels keep the velum the tongue model gives setTonguePosition(),
+        // judged in 44-section indices whatever the length; consonants use
+        // their own
+        sample_t velum = spec.velum;
+        if (i <= ARTICULATION_U) {
+            tract->setRestDiameter(spec.tongueIndex, spec.tongueDiameter);
+            tract->finishBlock();
+            velum = maxf(velum, props.noseDiameter[0]);
+        }
+
+        tract->setRestDiameter(spec.tongueIndex * scale, spec.tongueDiameter);
+        tract->setConstriction(spec.constrictionIndex < 0 ? -1 : spec.constrictionIndex * scale,
+                               spec.constrictionDiameter, 0);
+        tract->finishBlock();
+
+        t_areaFunction &preset = this->presets[i];
+        preset.n = tractLength;
+        preset.velum = velum;
+        memcpy(preset.diameter, props.tractDiameter, tractLength * sizeof(sample_t));
+    }
+    delete tract;
+}
+
+static ArticulationPresets buildPresets(int tractLength)
+{
+    ArticulationPresets presets;
+    presets.build(tractLength);
+    return presets;
+}
+
+const ArticulationPresets &ArticulationPresets::getDefault(int tractLength)
+{
+    static const ArticulationPresets reduced = buildPresets(22);
+    static const ArticulationPresets full = buildPresets(44);
+    return tractLength == 22 ? reduced : full;
+}
+
+void ArticulationPresets::getTonguePosition(t_articulation articulation, sample_t &index, sample_t &diameter)
+{
+    index = specs[articulation].tongueIndex;
+    diameter = specs[articulation].tongueDiameter;
+}
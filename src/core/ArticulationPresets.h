@@ -0,0 +1,67 @@
+//==============================================================================
+// src/core/ArticulationPresets.h
+// Precomputed tract area functions for vowels and consonants
+//==============================================================================
+
+#ifndef ArticulationPresets_h
+#define ArticulationPresets_h
+
+#include "config.h"
+
+#define AREA_FUNCTION_MAX_LENGTH (44)
+
+// Rest shape of the oral tract as n section diameters, plus the velum opening
+typedef struct t_areaFunction {
+    int n;
+    sample_t velum;
+    sample_t diameter[AREA_FUNCTION_MAX_LENGTH];
+} t_areaFunction;
+
+// out = a + (b - a) * amount, element-wise; a and b must have the same n
+void blendAreaFunctions(const t_areaFunction &a, const t_areaFunction &b, sample_t amount, t_areaFunction &out);
+
+typedef enum t_articulation {
+    ARTICULATION_A,     // vowels, in t_vowel order
+    ARTICULATION_E,
+    ARTICULATION_I,
+    ARTICULATION_O,
+    ARTICULATION_U,
+    ARTICULATION_M,     // nasals
+    ARTICULATION_N,
+    ARTICULATION_NG,
+    ARTICULATION_B,     // stop closures
+    ARTICULATION_D,
+    ARTICULATION_G,
+    ARTICULATION_F,     // fricative channels; the noise itself still needs setConstriction()
+    ARTICULATION_S,
+    ARTICULATION_SH,
+    NUM_ARTICULATIONS
+} t_articulation;
+
+// One area function per articulation, rendered once through a tract of the
+// matching length so they match what setTonguePosition() and
+// setConstriction() would produce. Articulation changes then become blends
+// of two vectors instead of a tongue-curve recomputation.
+class ArticulationPresets {
+public:
+    ArticulationPresets();
+
+    void build(int tractLength);
+    bool isReady() const { return presets[0].n > 0; }
+
+    const t_areaFunction &get(t_articulation articulation) const { return presets[articulation]; }
+    // Replaces a preset, e.g. with a shape captured from a live voice
+    void set(t_articulation articulation, const t_areaFunction &shape) { presets[articulation] = shape; }
+
+    // Built on first use for tract lengths 22 and 44, which allocates and
+    // takes the static-initialization lock; VoicePool builds them up front
+    static const ArticulationPresets &getDefault(int tractLength);
+
+    // Tongue position behind each preset, in 44-section tract indices
+    static void getTonguePosition(t_articulation articulation, sample_t &index, sample_t &diameter);
+
+private:
+    t_areaFunction presets[NUM_ARTICULATIONS];
+};
+
+#endif /* ArticulationPresets_h */
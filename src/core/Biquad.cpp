@@ -8,10 +8,6 @@
 #include "Biquad.h"
 #include <math.h>
 
-Biquad::~Biquad() {
-    // Empty destructor is fine for this class
-}
-
 
 Biquad::Biquad(sample_t sampleRate) :
 	frequency(200),
@@ -9,16 +9,19 @@
 #define Biquad_h
 
 #include <stdio.h>
+#include <cmath>
 #include "config.h"
 
 class Biquad {
 public:
 	Biquad(sample_t sampleRate);
-	~Biquad();
+	~Biquad() = default; // keeps the class trivially copyable for voice snapshots
 	void setFrequency(sample_t f);
 	void setQ(sample_t f);
 	void setGain(sample_t g);
 	sample_t runStep(sample_t xn);
+	// False once the filter history has gone NaN or infinite
+	bool isStable() const { return std::isfinite(this->ym1) && std::isfinite(this->ym2); }
 private:
 	void updateCoefficients();
 	
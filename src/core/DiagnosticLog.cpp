@@ -0,0 +1,145 @@
+//==============================================================================
+// src/core/DiagnosticLog.cpp
+//==============================================================================
+
+#include "DiagnosticLog.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string.h>
+
+DiagnosticLog::DiagnosticLog(const std::string &name, int capacity)
+    : name(name)
+    , sampleTime(0)
+    , head(0)
+    , tail(0)
+    , dropped(0) {
+    uint32_t size = 1;
+    while (size < (uint32_t) capacity) size <<= 1;
+    this->records = new t_logRecord[size];
+    this->ownsRecords = true;
+    this->mask = size - 1;
+}
+
+DiagnosticLog::DiagnosticLog(const std::string &name, t_logRecord *storage, int capacity)
+    : name(name)
+    , records(storage)
+    , ownsRecords(false)
+    , mask(capacity - 1)
+    , sampleTime(0)
+    , head(0)
+    , tail(0)
+    , dropped(0) {
+}
+
+DiagnosticLog::~DiagnosticLog() {
+    if (this->ownsRecords) delete[] this->records;
+}
+
+bool DiagnosticLog::push(t_logRecordType type, const float *values, int count) {
+    uint32_t h = this->head.load(std::memory_order_relaxed);
+    if (h - this->tail.load(std::memory_order_acquire) > this->mask) {
+        this->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    t_logRecord &record = this->records[h & this->mask];
+    record.type = type;
+    record.reserved = 0;
+    record.sampleTime = this->sampleTime;
+    count = std::min(count, LOG_RECORD_VALUES);
+    memcpy(record.values, values, count * sizeof(float));
+    memset(record.values + count, 0, (LOG_RECORD_VALUES - count) * sizeof(float));
+    this->head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+bool DiagnosticLog::push(t_logRecordType type, float value) {
+    return this->push(type, &value, 1);
+}
+
+bool DiagnosticLog::pop(t_logRecord &record) {
+    uint32_t t = this->tail.load(std::memory_order_relaxed);
+    if (t == this->head.load(std::memory_order_acquire)) return false;
+    record = this->records[t & this->mask];
+    this->tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+//==============================================================================
+
+DiagnosticLogWriter::DiagnosticLogWriter(std::ostream &out, int intervalMs)
+    : out(out)
+    , intervalMs(intervalMs)
+    , running(true) {
+    this->thread = std::thread(&DiagnosticLogWriter::run, this);
+}
+
+DiagnosticLogWriter::~DiagnosticLogWriter() {
+    this->running = false;
+    if (this->thread.joinable()) this->thread.join();
+    this->flush();
+}
+
+DiagnosticLogWriter &DiagnosticLogWriter::getShared() {
+    static DiagnosticLogWriter writer(std::cout);
+    return writer;
+}
+
+void DiagnosticLogWriter::addLog(DiagnosticLog *log) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->logs.push_back(log);
+}
+
+void DiagnosticLogWriter::removeLog(DiagnosticLog *log) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->drain(log);
+    this->logs.erase(std::remove(this->logs.begin(), this->logs.end(), log), this->logs.end());
+}
+
+void DiagnosticLogWriter::flush() {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (DiagnosticLog *log : this->logs) this->drain(log);
+    this->out.flush();
+}
+
+void DiagnosticLogWriter::run() {
+    while (this->running) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(this->intervalMs));
+        this->flush();
+    }
+}
+
+void DiagnosticLogWriter::drain(DiagnosticLog *log) {
+    t_logRecord record;
+    while (log->pop(record)) format(this->out, log->getName(), record);
+}
+
+void DiagnosticLogWriter::format(std::ostream &out, const std::string &name, const t_logRecord &record) {
+    const float *v = record.values;
+    out << "[" << name << " @" << record.sampleTime << "] ";
+    switch (record.type) {
+        case LOG_TRACT_INFO:
+            out << "Tract length: " << v[0]
+                << ", tongue bounds: " << v[1] << " to " << v[2]
+                << ", blade start: " << v[3] << ", tip start: " << v[4];
+            break;
+        case LOG_PARAMETERS:
+            out << "Frequency: " << v[0] << ", tenseness: " << v[1]
+                << ", tongue: " << v[2] << ", " << v[3]
+                << ", constriction: " << v[4] << ", " << v[5];
+            break;
+        case LOG_TRANSIENT:
+            out << "Transient at " << v[0];
+            break;
+        case LOG_NAN:
+            out << "NaN or infinity in output at frame " << v[0];
+            break;
+        case LOG_RECOVERY:
+            out << "Unstable state, voice reset (" << v[0] << " so far)";
+            break;
+        default:
+            out << "Unknown record " << record.type;
+            break;
+    }
+    out << "\n";
+}
@@ -0,0 +1,91 @@
+//==============================================================================
+// src/core/DiagnosticLog.h
+// Wait-free per-voice diagnostic log, drained by a background writer thread
+//==============================================================================
+
+#ifndef DiagnosticLog_h
+#define DiagnosticLog_h
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "config.h"
+
+typedef enum t_logRecordType {
+    LOG_TRACT_INFO,     // n, tongue lower bound, tongue upper bound, blade start, tip start
+    LOG_PARAMETERS,     // frequency, tenseness, tongue index, tongue diameter, constriction index, constriction diameter
+    LOG_TRANSIENT,      // position
+    LOG_NAN,            // sample index within the block of NaN or infinite output
+    LOG_RECOVERY        // recovery count, see PinkTrombone::setRecoveryState()
+} t_logRecordType;
+
+#define LOG_RECORD_VALUES (6)
+
+typedef struct t_logRecord {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sampleTime;
+    float values[LOG_RECORD_VALUES];
+} t_logRecord;
+
+// Single producer (the audio thread), single consumer (the writer thread).
+// push() never blocks or allocates; records are dropped when the ring is full.
+class DiagnosticLog {
+public:
+    DiagnosticLog(const std::string &name, int capacity = 256);
+    // Uses, but does not own, storage; capacity must be a power of two
+    DiagnosticLog(const std::string &name, t_logRecord *storage, int capacity);
+    ~DiagnosticLog();
+
+    // Audio thread
+    void setSampleTime(uint64_t sampleTime) { this->sampleTime = sampleTime; }
+    bool push(t_logRecordType type, const float *values, int count);
+    bool push(t_logRecordType type, float value);
+
+    // Consumer thread
+    bool pop(t_logRecord &record);
+    long getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+    const std::string &getName() const { return name; }
+
+private:
+    std::string name;
+    t_logRecord *records;
+    bool ownsRecords;
+    uint32_t mask;
+    uint64_t sampleTime;
+    std::atomic<uint32_t> head;     // written by the producer
+    std::atomic<uint32_t> tail;     // written by the consumer
+    std::atomic<long> dropped;
+};
+
+// Formats and writes records from any number of logs on a background thread
+class DiagnosticLogWriter {
+public:
+    DiagnosticLogWriter(std::ostream &out, int intervalMs = 50);
+    ~DiagnosticLogWriter();
+
+    void addLog(DiagnosticLog *log);
+    void removeLog(DiagnosticLog *log);     // drains the log before returning
+    void flush();
+
+    // Writer on std::cout, started on first use
+    static DiagnosticLogWriter &getShared();
+
+private:
+    void run();
+    void drain(DiagnosticLog *log);
+    static void format(std::ostream &out, const std::string &name, const t_logRecord &record);
+
+    std::ostream &out;
+    int intervalMs;
+    std::mutex mutex;
+    std::vector<DiagnosticLog *> logs;
+    std::atomic<bool> running;
+    std::thread thread;
+};
+
+#endif /* DiagnosticLog_h */
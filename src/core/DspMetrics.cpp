@@ -0,0 +1,96 @@
+//==============================================================================
+// src/core/DspMetrics.cpp
+//==============================================================================
+
+#include "DspMetrics.h"
+
+DspMetrics::DspMetrics()
+    : xrunRiskLoad(METRICS_XRUN_RISK_LOAD) {
+    this->reset();
+}
+
+void DspMetrics::reset() {
+    this->renderTime = 0;
+    this->load = 0;
+    this->peakLoad = 0;
+    this->xrunRiskCount = 0;
+    this->blockCount = 0;
+    for (int i = 0; i < METRICS_HISTOGRAM_BINS; i++) this->histogram[i] = 0;
+    this->windowPosition = 0;
+    this->windowFill = 0;
+}
+
+void DspMetrics::beginBlock() {
+    this->blockStart = clock::now();
+}
+
+void DspMetrics::endBlock(int numFrames, float sampleRate) {
+    float elapsed = std::chrono::duration<float, std::micro>(clock::now() - this->blockStart).count();
+    float budget = 1e6f * (float) numFrames / sampleRate;
+    float blockLoad = budget > 0 ? 100.0f * elapsed / budget : 0;
+
+    this->renderTime.store(elapsed, std::memory_order_relaxed);
+    this->load.store(blockLoad, std::memory_order_relaxed);
+    if (blockLoad > this->peakLoad.load(std::memory_order_relaxed)) {
+        this->peakLoad.store(blockLoad, std::memory_order_relaxed);
+    }
+    if (blockLoad > this->xrunRiskLoad) {
+        this->xrunRiskCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    this->blockCount.fetch_add(1, std::memory_order_relaxed);
+
+    // Rolling histogram: retire the oldest block once the window is full
+    int bin = (int) blockLoad;
+    if (bin >= METRICS_HISTOGRAM_BINS) bin = METRICS_HISTOGRAM_BINS - 1;
+    if (this->windowFill == METRICS_WINDOW_BLOCKS) {
+        this->histogram[this->windowBins[this->windowPosition]].fetch_sub(1, std::memory_order_relaxed);
+    } else {
+        this->windowFill++;
+    }
+    this->windowBins[this->windowPosition] = (uint8_t) bin;
+    this->histogram[bin].fetch_add(1, std::memory_order_relaxed);
+    this->windowPosition = (this->windowPosition + 1) % METRICS_WINDOW_BLOCKS;
+}
+
+float DspMetrics::getRenderTime() const {
+    return this->renderTime.load(std::memory_order_relaxed);
+}
+
+float DspMetrics::getLoad() const {
+    return this->load.load(std::memory_order_relaxed);
+}
+
+float DspMetrics::getPeakLoad() const {
+    return this->peakLoad.load(std::memory_order_relaxed);
+}
+
+long DspMetrics::getXrunRiskCount() const {
+    return this->xrunRiskCount.load(std::memory_order_relaxed);
+}
+
+long DspMetrics::getBlockCount() const {
+    return this->blockCount.load(std::memory_order_relaxed);
+}
+
+void DspMetrics::getHistogram(uint32_t *bins) const {
+    for (int i = 0; i < METRICS_HISTOGRAM_BINS; i++) {
+        bins[i] = this->histogram[i].load(std::memory_order_relaxed);
+    }
+}
+
+float DspMetrics::getLoadPercentile(float percentile) const {
+    uint32_t bins[METRICS_HISTOGRAM_BINS];
+    this->getHistogram(bins);
+    uint64_t total = 0;
+    for (int i = 0; i < METRICS_HISTOGRAM_BINS; i++) total += bins[i];
+    if (total == 0) return 0;
+
+    // Upper edge of the bin containing the requested rank
+    uint64_t rank = (uint64_t) (percentile / 100.0f * (float) (total - 1)) + 1;
+    uint64_t count = 0;
+    for (int i = 0; i < METRICS_HISTOGRAM_BINS; i++) {
+        count += bins[i];
+        if (count >= rank) return (float) (i + 1);
+    }
+    return (float) METRICS_HISTOGRAM_BINS;
+}
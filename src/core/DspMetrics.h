@@ -0,0 +1,57 @@
+//==============================================================================
+// src/core/DspMetrics.h
+// Per-block render time and DSP load, written by the audio thread and read
+// lock-free from any other thread
+//==============================================================================
+
+#ifndef DspMetrics_h
+#define DspMetrics_h
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include "config.h"
+
+#define METRICS_HISTOGRAM_BINS      (128)   // 1% load per bin, last bin is >= 127%
+#define METRICS_WINDOW_BLOCKS       (1024)  // blocks covered by the rolling histogram
+#define METRICS_XRUN_RISK_LOAD      (80.0f) // percent of the buffer duration
+
+class DspMetrics {
+public:
+    DspMetrics();
+
+    // Audio thread
+    void beginBlock();
+    void endBlock(int numFrames, float sampleRate);
+
+    // Any thread
+    float getRenderTime() const;    // last block, in microseconds
+    float getLoad() const;          // last block, percent of the buffer duration
+    float getPeakLoad() const;      // since the last reset
+    float getLoadPercentile(float percentile) const;   // over the rolling window
+    long getXrunRiskCount() const;  // blocks above xrunRiskLoad
+    long getBlockCount() const;
+    void getHistogram(uint32_t *bins) const;    // METRICS_HISTOGRAM_BINS entries
+
+    void setXrunRiskLoad(float percent) { xrunRiskLoad = percent; }
+    void reset();   // not safe while the audio thread is rendering
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    clock::time_point blockStart;
+    float xrunRiskLoad;
+
+    std::atomic<float> renderTime;
+    std::atomic<float> load;
+    std::atomic<float> peakLoad;
+    std::atomic<long> xrunRiskCount;
+    std::atomic<long> blockCount;
+    std::atomic<uint32_t> histogram[METRICS_HISTOGRAM_BINS];
+
+    // Bin of each block in the window, owned by the audio thread
+    uint8_t windowBins[METRICS_WINDOW_BLOCKS];
+    int windowPosition, windowFill;
+};
+
+#endif /* DspMetrics_h */
@@ -0,0 +1,118 @@
+//==============================================================================
+// src/core/FastMath.h
+// Polynomial approximations used by the fast math quality tier
+//==============================================================================
+
+#ifndef FastMath_h
+#define FastMath_h
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "config.h"
+
+typedef enum t_mathQuality {
+    MATH_QUALITY_REFERENCE,     // libm in double precision, as originally written
+    MATH_QUALITY_FAST           // the float approximations below
+} t_mathQuality;
+
+// All functions are branch-free straight-line float code, so loops calling
+// them can be vectorized. Error bounds were measured against double-precision
+// libm evaluated at the same float arguments, over the stated ranges.
+
+static inline float fastFloatFromBits(uint32_t bits)
+{
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline uint32_t fastBitsFromFloat(float f)
+{
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    return bits;
+}
+
+// Nearest integer, halves away from zero, for |x| < 2^31. A truncating
+// conversion is a single instruction, where floorf() may be a libm call.
+static inline int32_t fastRound(float x)
+{
+    return (int32_t) (x + copysignf(0.5f, x));
+}
+
+// 2^x, relative error < 2.5e-7 for x in [-126, 126]; clamped outside
+static inline float fastExp2(float x)
+{
+    x = fminf(fmaxf(x, -126.0f), 126.0f);
+    int32_t n = fastRound(x);
+    float f = x - (float) n;                        // [-0.5, 0.5]
+    float p = 1.5403530e-4f;
+    p = p * f + 1.3333558e-3f;
+    p = p * f + 9.6181291e-3f;
+    p = p * f + 5.5504109e-2f;
+    p = p * f + 2.4022651e-1f;
+    p = p * f + 6.9314718e-1f;
+    p = p * f + 1.0f;
+    return p * fastFloatFromBits((uint32_t) (n + 127) << 23);
+}
+
+// e^x, relative error < 1.1e-6 for |x| <= 20 and < 4e-6 for |x| <= 87,
+// dominated by the float rounding of x * log2(e)
+static inline float fastExp(float x)
+{
+    return fastExp2(x * 1.44269504f);
+}
+
+// log2(x) for normal x > 0, error < 1.2e-7 absolute or relative, whichever
+// is larger
+static inline float fastLog2(float x)
+{
+    // x = m * 2^e with m in [sqrt(1/2), sqrt(2))
+    uint32_t bits = fastBitsFromFloat(x);
+    int32_t e = (int32_t) ((bits >> 23) & 0xff) - 127;
+    float m = fastFloatFromBits((bits & 0x007fffff) | 0x3f800000);
+    float big = m > 1.41421356f ? 1.0f : 0.0f;
+    m *= 1.0f - 0.5f * big;
+    e += (int32_t) big;
+    // log2(m) = 2/ln2 * atanh(t), t = (m - 1) / (m + 1), |t| < 0.172
+    float t = (m - 1.0f) / (m + 1.0f);
+    float t2 = t * t;
+    float p = 3.2059889e-1f;                        // 2/(9 ln2)
+    p = p * t2 + 4.1219858e-1f;                     // 2/(7 ln2)
+    p = p * t2 + 5.7707802e-1f;                     // 2/(5 ln2)
+    p = p * t2 + 9.6179669e-1f;                     // 2/(3 ln2)
+    p = p * t2 + 2.8853901f;                        // 2/ln2
+    return (float) e + p * t;
+}
+
+// ln(x) for normal x > 0, same bound as fastLog2()
+static inline float fastLog(float x)
+{
+    return fastLog2(x) * 0.69314718f;
+}
+
+// x^y for x > 0, relative error < 2.5e-7 + 1e-7 * |y log2 x|
+static inline float fastPow(float x, float y)
+{
+    return fastExp2(y * fastLog2(x));
+}
+
+// sin(x), absolute error < 2e-7 for |x| <= 2 pi and < 6e-6 for |x| <= 100;
+// beyond one period the float range reduction dominates
+static inline float fastSin(float x)
+{
+    const float twoPi = 6.28318531f, pi = 3.14159265f;
+    x -= twoPi * (float) fastRound(x * (1.0f / twoPi));   // [-pi, pi]
+    float a = fabsf(x);
+    float y = copysignf(fminf(a, pi - a), x);       // [-pi/2, pi/2], same sine
+    float y2 = y * y;
+    float p = -2.5052108e-8f;
+    p = p * y2 + 2.7557319e-6f;
+    p = p * y2 - 1.9841270e-4f;
+    p = p * y2 + 8.3333333e-3f;
+    p = p * y2 - 1.6666667e-1f;
+    return y + y * y2 * p;
+}
+
+#endif /* FastMath_h */
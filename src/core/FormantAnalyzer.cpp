@@ -0,0 +1,225 @@
+//==============================================================================
+// src/core/FormantAnalyzer.cpp
+//==============================================================================
+
+#include "FormantAnalyzer.h"
+#include <math.h>
+
+// Per-section loss of the oral waveguide, as applied in BasicTract::runStep()
+#define ORAL_LOSS (0.999)
+
+// Wave variables at a junction: a and b arrive from the left and right, c and
+// d leave to the right and left. A junction with reflection r maps the right
+// side (c, b) to the left side (a, d):
+//     [a]     1    [1 r] [c]
+//     [d] = ----- [r 1] [b]
+//           1 - r
+// and a one-sample section with loss g maps its right end to its left end:
+//     [c]   [z/g    0] [a']
+//     [b] = [0    g/z] [d']
+struct WaveVector {
+    std::complex<double> forward, backward;
+
+    void junction(double r) {
+        double scale = 1.0 / (1.0 - r);
+        std::complex<double> f = (forward + r * backward) * scale;
+        std::complex<double> b = (r * forward + backward) * scale;
+        forward = f;
+        backward = b;
+    }
+
+    void section(std::complex<double> z, double g) {
+        forward *= z / g;
+        backward *= g / z;
+    }
+};
+
+static double areaReflection(double leftArea, double rightArea) {
+    // BasicTract::calculateReflections() pins closed sections to 0.999
+    if (rightArea == 0) return 0.999;
+    return (leftArea - rightArea) / (leftArea + rightArea);
+}
+
+FormantAnalyzer::FormantAnalyzer()
+    : noseMix(0.8)
+    , gridSampleRate(0)
+    , gridDirty(true)
+    , responseDirty(true)
+    , hasNose(false)
+    , lastVersion(0)
+    , noseKeyLength(0)
+    , formantCount(0) {
+    this->setFrequencyRange(0, 5000, 512);
+}
+
+void FormantAnalyzer::setFrequencies(const std::vector<sample_t> &frequencies) {
+    this->frequencies = frequencies;
+    this->gridDirty = true;
+}
+
+void FormantAnalyzer::setFrequencyRange(sample_t minFrequency, sample_t maxFrequency, int count) {
+    this->frequencies.resize(count);
+    for (int i = 0; i < count; i++) {
+        this->frequencies[i] = minFrequency + (maxFrequency - minFrequency) * i / (sample_t) std::max(1, count - 1);
+    }
+    this->gridDirty = true;
+}
+
+void FormantAnalyzer::setNoseMix(sample_t noseMix) {
+    this->noseMix = noseMix;
+    this->responseDirty = true;
+}
+
+bool FormantAnalyzer::update(const t_tractShape &shape) {
+    if (shape.n <= 0) return false;
+    if (this->gridDirty || shape.sampleRate != this->gridSampleRate) this->updateGrid(shape.sampleRate);
+    if (!this->responseDirty && shape.version == this->lastVersion) return false;
+
+    this->updateNose(shape);
+    this->updateResponse(shape);
+    this->findFormants();
+    this->lastVersion = shape.version;
+    this->responseDirty = false;
+    return true;
+}
+
+void FormantAnalyzer::updateGrid(sample_t sampleRate) {
+    size_t count = this->frequencies.size();
+    this->z.resize(count);
+    this->response.assign(count, 0);
+    this->noseReflectance.resize(count);
+    this->noseTransfer.resize(count);
+    for (size_t k = 0; k < count; k++) {
+        this->z[k] = std::polar(1.0, 2.0 * M_PI * this->frequencies[k] / sampleRate);
+    }
+    this->gridSampleRate = sampleRate;
+    this->gridDirty = false;
+    this->hasNose = false;
+    this->responseDirty = true;
+}
+
+// The nasal branch only changes with the velum, so its reflectance and
+// transfer are kept until the nose diameters differ
+void FormantAnalyzer::updateNose(const t_tractShape &shape) {
+    int length = shape.noseLength;
+    if (this->hasNose && length == this->noseKeyLength
+        && memcmp(this->noseKey, shape.noseDiameter, length * sizeof(sample_t)) == 0) {
+        return;
+    }
+
+    double reflection[TRACT_SHAPE_MAX_NOSE_LENGTH];
+    for (int j = 1; j < length; j++) {
+        double left = shape.noseDiameter[j - 1] * shape.noseDiameter[j - 1];
+        double right = shape.noseDiameter[j] * shape.noseDiameter[j];
+        reflection[j] = left + right == 0 ? 0 : (left - right) / (left + right);
+    }
+
+    for (size_t k = 0; k < this->z.size(); k++) {
+        // Unit wave leaving the nostrils, reflected back with the lip reflection
+        WaveVector v = { 1.0, LIP_REFLECTION };
+        for (int j = length - 1; j >= 0; j--) {
+            v.section(this->z[k], TRACT_FADE);
+            if (j > 0) v.junction(reflection[j]);
+        }
+        this->noseReflectance[k] = v.backward / v.forward;
+        this->noseTransfer[k] = 1.0 / v.forward;
+    }
+
+    memcpy(this->noseKey, shape.noseDiameter, length * sizeof(sample_t));
+    this->noseKeyLength = length;
+    this->hasNose = true;
+}
+
+void FormantAnalyzer::updateResponse(const t_tractShape &shape) {
+    int n = shape.n;
+    int noseStart = shape.noseStart;
+
+    double area[TRACT_SHAPE_MAX_LENGTH];
+    for (int i = 0; i < n; i++) area[i] = shape.diameter[i] * shape.diameter[i];
+    double reflection[TRACT_SHAPE_MAX_LENGTH];
+    for (int i = 1; i < n; i++) reflection[i] = areaReflection(area[i - 1], area[i]);
+
+    // Three-way junction, as in BasicTract::calculateReflections()
+    double noseArea = shape.noseDiameter[0] * shape.noseDiameter[0];
+    double sum = area[noseStart] + area[noseStart + 1] + noseArea;
+    double reflectionLeft = (2 * area[noseStart] - sum) / sum;
+    double reflectionRight = (2 * area[noseStart + 1] - sum) / sum;
+    double reflectionNose = (2 * noseArea - sum) / sum;
+
+    for (size_t k = 0; k < this->z.size(); k++) {
+        complex nose = 0;
+        WaveVector v = { 1.0, LIP_REFLECTION };
+        for (int i = n - 1; i >= 0; i--) {
+            v.section(this->z[k], ORAL_LOSS);
+            if (i == noseStart) {
+                // The nasal wave returning into the junction is a fixed
+                // multiple kappa of the sum of the oral waves arriving there
+                complex gamma = this->noseReflectance[k];
+                complex toNose = (1.0 + reflectionNose) / (1.0 - reflectionNose * gamma);
+                complex kappa = gamma * toNose;
+                complex right = (1.0 + reflectionRight) * (1.0 + kappa);
+                if (std::abs(right) < 1e-12) right = 1e-12;
+                complex p = 1.0 / right;
+                complex q = -(reflectionRight + (1.0 + reflectionRight) * kappa) * p;
+                complex alpha = reflectionLeft + (1.0 + reflectionLeft) * kappa;
+                complex beta = (1.0 + reflectionLeft) * (1.0 + kappa);
+                complex b = v.backward;
+                complex a = p * v.forward + q * b;
+                v.backward = alpha * a + beta * b;
+                v.forward = a;
+                nose = this->noseTransfer[k] * toNose * (a + b);
+            } else if (i > 0) {
+                v.junction(reflection[i]);
+            }
+        }
+        // The glottis injects its wave on top of the reflected one
+        complex glottal = v.forward - GLOTTAL_REFLECTION * v.backward;
+        complex h = (1.0 + (double) this->noseMix * nose) / glottal;
+        this->response[k] = (sample_t) (20.0 * log10(std::max(std::abs(h), 1e-12)));
+    }
+}
+
+// Peaks of the response with parabolic interpolation, bandwidths from the
+// -3 dB crossings on either side
+void FormantAnalyzer::findFormants() {
+    const std::vector<sample_t> &f = this->frequencies;
+    const std::vector<sample_t> &r = this->response;
+    int count = (int) r.size();
+    this->formantCount = 0;
+    for (int k = 1; k < count - 1 && this->formantCount < NUM_FORMANTS; k++) {
+        if (!(r[k] > r[k - 1] && r[k] >= r[k + 1])) continue;
+
+        sample_t frequency = f[k];
+        sample_t peak = r[k];
+        sample_t curvature = r[k - 1] - 2 * r[k] + r[k + 1];
+        if (curvature < 0) {
+            sample_t offset = 0.5 * (r[k - 1] - r[k + 1]) / curvature;
+            sample_t spacing = offset < 0 ? f[k] - f[k - 1] : f[k + 1] - f[k];
+            frequency += offset * spacing;
+            peak -= 0.25 * (r[k - 1] - r[k + 1]) * offset;
+        }
+
+        sample_t threshold = peak - 3;
+        sample_t low = -1, high = -1;
+        for (int i = k; i > 0; i--) {
+            if (r[i - 1] < threshold) {
+                low = f[i - 1] + (f[i] - f[i - 1]) * (threshold - r[i - 1]) / (r[i] - r[i - 1]);
+                break;
+            }
+        }
+        for (int i = k; i < count - 1; i++) {
+            if (r[i + 1] < threshold) {
+                high = f[i] + (f[i + 1] - f[i]) * (r[i] - threshold) / (r[i] - r[i + 1]);
+                break;
+            }
+        }
+        sample_t bandwidth = 0;
+        if (low >= 0 && high >= 0) bandwidth = high - low;
+        else if (low >= 0) bandwidth = 2 * (frequency - low);
+        else if (high >= 0) bandwidth = 2 * (high - frequency);
+
+        this->formants[this->formantCount].frequency = frequency;
+        this->formants[this->formantCount].bandwidth = bandwidth;
+        this->formantCount++;
+    }
+}
@@ -0,0 +1,71 @@
+//==============================================================================
+// src/core/FormantAnalyzer.h
+// Analytic frequency response and formants of a tract shape
+//==============================================================================
+
+#ifndef FormantAnalyzer_h
+#define FormantAnalyzer_h
+
+#include <complex>
+#include <vector>
+#include "config.h"
+#include "TractShape.h"
+
+#define NUM_FORMANTS (4)
+
+typedef struct t_formant {
+    sample_t frequency;     // Hz
+    sample_t bandwidth;     // Hz between the -3 dB points
+} t_formant;
+
+// Evaluates the transfer function from glottis to output of the waveguide that
+// BasicTract runs, using 2x2 wave chain matrices: one per junction (from the
+// same reflection coefficients the tract computes) and one per one-sample
+// section delay. The nasal branch is reduced to its reflectance at the
+// three-way junction and its own transfer to the nostrils. Works on
+// t_tractShape copies, so it never touches the audio thread, and only
+// recomputes what changed since the last update().
+class FormantAnalyzer {
+public:
+    FormantAnalyzer();
+
+    // Evaluation frequencies in Hz, ascending. Defaults to 512 points up to 5 kHz.
+    void setFrequencies(const std::vector<sample_t> &frequencies);
+    void setFrequencyRange(sample_t minFrequency, sample_t maxFrequency, int count);
+    // Weight of the nose output in the mix, as in PinkTrombone::synthesize()
+    void setNoseMix(sample_t noseMix);
+
+    // Returns true if the response was recomputed
+    bool update(const t_tractShape &shape);
+
+    const std::vector<sample_t> &getFrequencies() const { return frequencies; }
+    const std::vector<sample_t> &getResponse() const { return response; }     // dB
+    int getFormantCount() const { return formantCount; }
+    const t_formant &getFormant(int index) const { return formants[index]; }
+
+private:
+    typedef std::complex<double> complex;
+
+    void updateGrid(sample_t sampleRate);
+    void updateNose(const t_tractShape &shape);
+    void updateResponse(const t_tractShape &shape);
+    void findFormants();
+
+    std::vector<sample_t> frequencies;
+    std::vector<sample_t> response;
+    std::vector<complex> z;
+    std::vector<complex> noseReflectance, noseTransfer;
+
+    sample_t noseMix;
+    sample_t gridSampleRate;
+    bool gridDirty, responseDirty;
+    bool hasNose;
+    unsigned int lastVersion;
+    int noseKeyLength;
+    sample_t noseKey[TRACT_SHAPE_MAX_NOSE_LENGTH];
+
+    t_formant formants[NUM_FORMANTS];
+    int formantCount;
+};
+
+#endif /* FormantAnalyzer_h */
@@ -0,0 +1,229 @@
+//==============================================================================
+// src/core/FormantFilter.cpp
+//==============================================================================
+
+#include "FormantFilter.h"
+#include <math.h>
+#include <cmath>
+#include "util.h"
+
+// Per-section loss of the oral waveguide, as in FormantAnalyzer
+#define ORAL_LOSS (0.999)
+// Curvature of a resonance peak in dB: -80 / ln(10) over the squared bandwidth
+#define PEAK_CURVATURE (34.7436)
+
+static const sample_t neutralFormants[FORMANT_LANES] = { 500, 1500, 2500, 3500 };
+
+FormantFilter::FormantFilter(sample_t sampleRate):
+    lipOutput(0),
+    noseOutput(0),
+    sampleRate(sampleRate),
+    noiseGain(0),
+    nasalY1(0),
+    nasalY2(0),
+    lastVersion(~0u),
+    holdBlocks(0),
+    gridGroup(0)
+{
+    for (int k = 0; k < FORMANT_LANES; k++) {
+        this->formants[k].frequency = neutralFormants[k];
+        this->formants[k].bandwidth = 100;
+        this->setResonator(this->formants[k].frequency, this->formants[k].bandwidth,
+                           this->tuning.a[k], this->tuning.b[k], this->tuning.c[k]);
+        this->y1[k] = this->y2[k] = 0;
+    }
+    this->tuning.oralGain = 1;
+    this->tuning.nasalGain = 0;
+    this->newTuning = this->tuning;
+    this->setResonator(FORMANT_NASAL_FREQUENCY, FORMANT_NASAL_BANDWIDTH, this->nasalA, this->nasalB, this->nasalC);
+}
+
+// Two-pole resonator with unity gain at DC, so a cascade of them keeps the
+// relative formant levels of the tube
+void FormantFilter::setResonator(sample_t frequency, sample_t bandwidth, sample_t &a, sample_t &b, sample_t &c)
+{
+    double radius = exp(-M_PI * bandwidth / this->sampleRate);
+    c = (sample_t) -(radius * radius);
+    b = (sample_t) (2 * radius * cos(2 * M_PI * frequency / this->sampleRate));
+    a = 1 - b - c;
+}
+
+void FormantFilter::runStep(sample_t glottalOutput, sample_t turbulenceNoise, sample_t lambda, sample_t glottalNoiseModulator)
+{
+    const Tuning &from = this->tuning;
+    const Tuning &to = this->newTuning;
+
+    // Each resonator takes the output of the one before from the last sample
+    alignas(16) sample_t x[FORMANT_LANES];
+    x[0] = glottalOutput;
+    for (int k = 1; k < FORMANT_LANES; k++) x[k] = this->y1[k - 1];
+    x[FORMANT_NOISE_LANE] += turbulenceNoise * glottalNoiseModulator * this->noiseGain;
+
+    for (int k = 0; k < FORMANT_LANES; k++) {
+        sample_t a = from.a[k] + (to.a[k] - from.a[k]) * lambda;
+        sample_t b = from.b[k] + (to.b[k] - from.b[k]) * lambda;
+        sample_t c = from.c[k] + (to.c[k] - from.c[k]) * lambda;
+        sample_t y = a * x[k] + b * this->y1[k] + c * this->y2[k];
+        this->y2[k] = this->y1[k];
+        this->y1[k] = y;
+    }
+
+    sample_t nasal = this->nasalA * glottalOutput + this->nasalB * this->nasalY1 + this->nasalC * this->nasalY2;
+    this->nasalY2 = this->nasalY1;
+    this->nasalY1 = nasal;
+
+    sample_t oralGain = from.oralGain + (to.oralGain - from.oralGain) * lambda;
+    sample_t nasalGain = from.nasalGain + (to.nasalGain - from.nasalGain) * lambda;
+    this->lipOutput = this->y1[FORMANT_LANES - 1] * oralGain;
+    this->noseOutput = nasal * nasalGain;
+}
+
+void FormantFilter::finishBlock(const t_tractProps &props, const t_constriction *constrictions, int numConstrictions)
+{
+    this->tuning = this->newTuning;
+    if (this->holdBlocks > 0) this->holdBlocks--;
+    if (props.shapeVersion != this->lastVersion && this->holdBlocks == 0) {
+        this->tune(this->newTuning, props);
+        this->lastVersion = props.shapeVersion;
+        this->holdBlocks = FORMANT_TUNE_INTERVAL - 1;
+    }
+
+    // Turbulence of every fricative constriction, as
+    // BasicTract::updateTurbulenceSources() would inject it, summed into one
+    // source
+    this->noiseGain = 0;
+    for (int i = 0; i < numConstrictions; i++) {
+        const t_constriction &c = constrictions[i];
+        if (c.fricative <= 0 || c.index < 2.0 || c.index > (sample_t) props.n - 1 || c.diameter <= 0.0) continue;
+        sample_t thinness0 = clamp(8.0 * (0.7 - c.diameter), 0.0, 1.0);
+        sample_t openness = clamp(30.0 * (c.diameter - 0.3), 0.0, 1.0);
+        this->noiseGain += 0.66 * c.fricative * thinness0 * openness;
+    }
+}
+
+void FormantFilter::reset(const t_tractProps &props)
+{
+    for (int k = 0; k < FORMANT_LANES; k++) this->y1[k] = this->y2[k] = 0;
+    this->nasalY1 = this->nasalY2 = 0;
+    this->lipOutput = this->noseOutput = 0;
+    this->tune(this->newTuning, props);
+    this->tuning = this->newTuning;
+    this->lastVersion = props.shapeVersion;
+    this->holdBlocks = 0;
+}
+
+bool FormantFilter::isStable() const
+{
+    sample_t sum = this->nasalY1 + this->nasalY2;
+    for (int k = 0; k < FORMANT_LANES; k++) sum += this->y1[k] + this->y2[k];
+    return std::isfinite(sum);
+}
+
+void FormantFilter::tune(Tuning &tuning, const t_tractProps &props)
+{
+    this->estimate(props);
+    for (int k = 0; k < FORMANT_LANES; k++) {
+        this->setResonator(this->formants[k].frequency, this->formants[k].bandwidth,
+                           tuning.a[k], tuning.b[k], tuning.c[k]);
+    }
+
+    // A closure anywhere silences the mouth
+    sample_t narrowest = props.tractDiameter[2];
+    for (int i = 3; i < props.n; i++) narrowest = minf(narrowest, props.tractDiameter[i]);
+    sample_t open = clamp(narrowest / FORMANT_CLOSURE_DIAMETER, 0.0, 1.0);
+    tuning.oralGain = open * open;
+    tuning.nasalGain = FORMANT_NASAL_GAIN * clamp((props.noseDiameter[0] - NOSE_BYPASS_DIAMETER)
+                                                  / (FORMANT_VELUM_OPEN - NOSE_BYPASS_DIAMETER), 0.0, 1.0);
+}
+
+void FormantFilter::updateGrid(int group)
+{
+    for (int k = 0; k < FORMANT_GRID_SIZE; k++) {
+        double frequency = FORMANT_MAX_FREQUENCY * (k + 1) / FORMANT_GRID_SIZE;
+        double phase = 2 * M_PI * frequency * group / this->sampleRate;
+        this->gridCos[k] = (sample_t) cos(phase);
+        this->gridSin[k] = (sample_t) sin(phase);
+    }
+    this->gridGroup = group;
+}
+
+// FormantAnalyzer::updateResponse() on a coarser tube and a coarser grid,
+// without the nasal branch: each section spans group samples of the
+// waveguide, so the chain is FORMANT_SECTIONS long whatever the tract length.
+// Peaks are refined with a parabola through the dB levels, whose curvature
+// also gives the bandwidth. The lowest peak found is at two grid steps, which
+// keeps the unity-gain cascade from losing the voice to a resonance below
+// the pitch.
+void FormantFilter::estimate(const t_tractProps &props)
+{
+    int group = std::max(1, props.n / FORMANT_SECTIONS);
+    int sections = std::min(props.n / group, FORMANT_SECTIONS);
+    if (group != this->gridGroup) this->updateGrid(group);
+
+    sample_t area[FORMANT_SECTIONS];
+    for (int s = 0; s < sections; s++) {
+        sample_t sum = 0;
+        for (int i = s * group; i < (s + 1) * group; i++) sum += props.tractDiameter[i] * props.tractDiameter[i];
+        area[s] = sum / group;
+    }
+    sample_t reflection[FORMANT_SECTIONS], scale[FORMANT_SECTIONS];
+    for (int s = 1; s < sections; s++) {
+        if (area[s] == 0) reflection[s] = 0.999;
+        else reflection[s] = (area[s - 1] - area[s]) / (area[s - 1] + area[s]);
+        scale[s] = 1 / (1 - reflection[s]);
+    }
+    sample_t loss = (sample_t) pow(ORAL_LOSS, group);
+    sample_t inverseLoss = 1 / loss;
+
+    // Squared magnitude of the glottal wave per unit output: the response
+    // peaks where it dips
+    sample_t power[FORMANT_GRID_SIZE];
+    for (int k = 0; k < FORMANT_GRID_SIZE; k++) {
+        sample_t zr = this->gridCos[k], zi = this->gridSin[k];
+        // Forward and backward waves at the lips, walked back to the glottis
+        sample_t fr = 1, fi = 0, br = LIP_REFLECTION, bi = 0;
+        for (int s = sections - 1; s >= 0; s--) {
+            sample_t t = fr;
+            fr = (t * zr - fi * zi) * inverseLoss;
+            fi = (t * zi + fi * zr) * inverseLoss;
+            t = br;
+            br = (t * zr + bi * zi) * loss;
+            bi = (bi * zr - t * zi) * loss;
+            if (s > 0) {
+                sample_t r = reflection[s];
+                sample_t nfr = (fr + r * br) * scale[s], nfi = (fi + r * bi) * scale[s];
+                br = (r * fr + br) * scale[s];
+                bi = (r * fi + bi) * scale[s];
+                fr = nfr;
+                fi = nfi;
+            }
+        }
+        sample_t gr = fr - GLOTTAL_REFLECTION * br;
+        sample_t gi = fi - GLOTTAL_REFLECTION * bi;
+        power[k] = maxf(gr * gr + gi * gi, 1e-30);
+    }
+
+    sample_t spacing = FORMANT_MAX_FREQUENCY / FORMANT_GRID_SIZE;
+    int count = 0;
+    for (int k = 1; k < FORMANT_GRID_SIZE - 1 && count < FORMANT_LANES; k++) {
+        if (!(power[k] < power[k - 1] && power[k] <= power[k + 1])) continue;
+        sample_t level[3];
+        for (int j = 0; j < 3; j++) level[j] = -10 * log10f(power[k - 1 + j]);
+        sample_t curvature = level[0] - 2 * level[1] + level[2];
+        sample_t frequency = spacing * (k + 1);
+        sample_t bandwidth = FORMANT_MAX_BANDWIDTH;
+        if (curvature < 0) {
+            frequency += spacing * 0.5 * (level[0] - level[2]) / curvature;
+            bandwidth = spacing * sqrtf(PEAK_CURVATURE / -curvature);
+        }
+        this->formants[count].frequency = frequency;
+        this->formants[count].bandwidth = clamp(bandwidth, FORMANT_MIN_BANDWIDTH, FORMANT_MAX_BANDWIDTH);
+        count++;
+    }
+    // Formants above the grid are spread out above the last one found
+    for (; count < FORMANT_LANES; count++) {
+        sample_t below = count > 0 ? this->formants[count - 1].frequency : 0;
+        this->formants[count].frequency = maxf(neutralFormants[count], below + 1000);
+        this->formants[count].bandwidth = 200;
+    }
+}
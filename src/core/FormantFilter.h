@@ -0,0 +1,102 @@
+//==============================================================================
+// src/core/FormantFilter.h
+// Cheap stand-in for the waveguide: formants estimated from the tract shape,
+// rendered through a cascade of resonators
+//==============================================================================
+
+#ifndef FormantFilter_h
+#define FormantFilter_h
+
+#include "config.h"
+#include "Tract.h"
+#include "FormantAnalyzer.h"
+
+#define FORMANT_LANES           (4)     // resonators, one formant each
+#define FORMANT_NOISE_LANE      (2)     // first resonator the fricative noise goes through
+#define FORMANT_SECTIONS        (11)    // of the coarse tube the formants are estimated on
+#define FORMANT_GRID_SIZE       (48)    // evaluation frequencies
+#define FORMANT_MAX_FREQUENCY   (4800.0)
+#define FORMANT_MIN_BANDWIDTH   (40.0)
+#define FORMANT_MAX_BANDWIDTH   (600.0)
+// Control blocks between estimates while the shape keeps changing
+#define FORMANT_TUNE_INTERVAL   (4)
+// Below this diameter of its narrowest section the mouth passes sound in
+// proportion to that section's area, as the waveguide does; the nose opens
+// from NOSE_BYPASS_DIAMETER up to this velum opening
+#define FORMANT_CLOSURE_DIAMETER    (0.35)
+#define FORMANT_VELUM_OPEN          (0.4)
+#define FORMANT_NASAL_FREQUENCY     (270.0)
+#define FORMANT_NASAL_BANDWIDTH     (100.0)
+#define FORMANT_NASAL_GAIN          (0.7)
+
+// Renders the voice from the same glottal and noise sources as a Tract, at a
+// fraction of its cost, for voices where the detail of the waveguide is lost,
+// e.g. distant or background ones. Has the runStep() / finishBlock() shape of
+// a Tract and reads the diameters a Tract publishes in t_tractProps, so the
+// tract keeps doing the articulation at control rate and only its per-sample
+// loop is replaced.
+//
+// At control rate the oral tract is merged into FORMANT_SECTIONS sections of
+// several samples' delay each, and the response of that tube is evaluated on
+// FORMANT_GRID_SIZE frequencies with the same chain matrices FormantAnalyzer
+// uses. Its lowest FORMANT_LANES peaks tune a cascade of unity-gain two-pole
+// resonators, at most every FORMANT_TUNE_INTERVAL blocks while the tract
+// moves and not at all while it holds still. The cascade is pipelined: each
+// resonator works on the output the previous one produced a sample earlier,
+// so all of them update at once from fixed-size arrays the compiler turns
+// into one vector operation each, for FORMANT_LANES - 1 samples of latency.
+// Fricative noise enters before the resonator FORMANT_NOISE_LANE, and the
+// nose is a single resonator opened by the velum. There are no transients.
+//
+// Trivially copyable, so it can be snapshotted with memcpy.
+class FormantFilter {
+public:
+    FormantFilter(sample_t sampleRate);
+
+    void runStep(sample_t glottalOutput, sample_t turbulenceNoise, sample_t lambda, sample_t glottalNoiseModulator);
+    // Control rate, after the tract's finishBlock(): retunes the resonators
+    // when the shape in props changed, ramping to the new tuning over the
+    // next block, and takes the fricative noise from the constrictions
+    void finishBlock(const t_tractProps &props, const t_constriction *constrictions, int numConstrictions);
+    // Clears the resonators and snaps to the shape in props
+    void reset(const t_tractProps &props);
+
+    // False once a resonator has gone NaN or infinite
+    bool isStable() const;
+
+    // Current estimate, lowest first; formants the grid does not reach are
+    // placed above the others
+    int getFormantCount() const { return FORMANT_LANES; }
+    const t_formant &getFormant(int index) const { return this->formants[index]; }
+
+    sample_t lipOutput;
+    sample_t noseOutput;
+
+private:
+    struct Tuning {
+        alignas(16) sample_t a[FORMANT_LANES];
+        alignas(16) sample_t b[FORMANT_LANES];
+        alignas(16) sample_t c[FORMANT_LANES];
+        sample_t oralGain, nasalGain;
+    };
+
+    void updateGrid(int group);
+    void estimate(const t_tractProps &props);
+    void tune(Tuning &tuning, const t_tractProps &props);
+    void setResonator(sample_t frequency, sample_t bandwidth, sample_t &a, sample_t &b, sample_t &c);
+
+    sample_t sampleRate;
+    Tuning tuning, newTuning;           // at the start and end of the block
+    sample_t noiseGain;
+    alignas(16) sample_t y1[FORMANT_LANES];
+    alignas(16) sample_t y2[FORMANT_LANES];
+    sample_t nasalA, nasalB, nasalC, nasalY1, nasalY2;
+
+    unsigned int lastVersion;
+    int holdBlocks;                     // before the next estimate
+    t_formant formants[FORMANT_LANES];
+    int gridGroup;                      // samples of delay per coarse section
+    sample_t gridCos[FORMANT_GRID_SIZE], gridSin[FORMANT_GRID_SIZE];
+};
+
+#endif /* FormantFilter_h */
@@ -10,11 +10,7 @@
 #include "noise.h"
 #include "util.h"
 
-Glottis::~Glottis() {
-    // Empty destructor is fine for this class
-}
-
-Glottis::Glottis(double sampleRate) :
+Glottis::Glottis(double sampleRate, double blockTime) :
 	timeInWaveform(0),
 	oldFrequency(140),
 	newFrequency(140),
@@ -23,23 +19,43 @@ Glottis::Glottis(double sampleRate) :
 	oldTenseness(0.6),
 	newTenseness(0.6),
 	targetTenseness(0.6),
+	directFrequency(-1),
+	directTenseness(-1),
 	totalTime(0.0),
+	totalSamples(0),
 	intensity(0),
 	loudness(1),
 	vibratoAmount(VIBRATO_AMOUNT),
 	vibratoFrequency(VIBRATO_FREQUENCY),
+	quality(PINK_TROMBONE_MATH_QUALITY),
 	autoWobble(false),
 	isTouched(false),
 	alwaysVoice(true)
 {
 	this->sampleRate = sampleRate;
+	this->samplePeriod = 1.0 / sampleRate;
+	this->setBlockTime(blockTime);
 	this->setupWaveform(0);
+	this->setSeed(timeseed());
+}
+
+void Glottis::setBlockTime(double blockTime)
+{
+	this->blockScale = blockTime / GLOTTIS_REFERENCE_BLOCK_TIME;
+	this->frequencyStep = pow(1.1, this->blockScale);
+}
+
+void Glottis::setSeed(short seed)
+{
+	simplexSeed(&this->simplex, seed);
 }
 
 void Glottis::setupWaveform(sample_t lambda)
 {
 	this->frequency = this->oldFrequency * (1 - lambda) + this->newFrequency * lambda;
 	sample_t tenseness = this->oldTenseness * (1 - lambda) + this->newTenseness * lambda;
+	if (this->directFrequency > 0) this->frequency = this->directFrequency;
+	if (this->directTenseness >= 0) tenseness = this->directTenseness;
 	this->Rd = 3 * (1 - tenseness);
 	this->waveformLength = 1.0 / this->frequency;
 	
@@ -56,7 +72,8 @@ void Glottis::setupWaveform(sample_t lambda)
 	sample_t Te = Tp + Tp * Rk;
 	
 	sample_t epsilon = 1 / Ta;
-	sample_t shift = exp(-epsilon * (1 - Te));
+	bool fast = this->quality == MATH_QUALITY_FAST;
+	sample_t shift = fast ? fastExp(-epsilon * (1 - Te)) : exp(-epsilon * (1 - Te));
 	sample_t Delta = 1 - shift; //divide by this to scale RHS
 	
 	sample_t RHSIntegral = (1 / epsilon) * (shift - 1) + (1 - Te) * shift;
@@ -66,7 +83,7 @@ void Glottis::setupWaveform(sample_t lambda)
 	sample_t totalUpperIntegral = -totalLowerIntegral;
 	
 	sample_t omega = M_PI / Tp;
-	sample_t s = sin(omega * Te);
+	sample_t s = fast ? fastSin(omega * Te) : sin(omega * Te);
 	// need E0*e^(alpha*Te)*s = -1 (to meet the return at -1)
 	// and E0*e^(alpha*Tp/2) * Tp*2/pi = totalUpperIntegral
 	//             (our approximation of the integral up to Tp)
@@ -76,9 +93,9 @@ void Glottis::setupWaveform(sample_t lambda)
 	// letting y = x^(Tp/2 - Te),
 	// y * Tp*2 / (pi*s) = -totalUpperIntegral;
 	sample_t y = -M_PI * s * totalUpperIntegral / (Tp * 2.0);
-	sample_t z = log(y);
+	sample_t z = fast ? fastLog(y) : log(y);
 	sample_t alpha = z / (Tp / 2.0 - Te);
-	sample_t E0 = -1.0 / (s * exp(alpha*Te));
+	sample_t E0 = -1.0 / (s * (fast ? fastExp(alpha*Te) : exp(alpha*Te)));
 	this->alpha = alpha;
 	this->E0 = E0;
 	this->epsilon = epsilon;
@@ -90,7 +107,11 @@ void Glottis::setupWaveform(sample_t lambda)
 
 sample_t Glottis::getNoiseModulator()
 {
-	sample_t voiced = 0.1 + 0.2 * fmax(0.0, sin(M_PI * 2 * this->timeInWaveform / this->waveformLength));
+	sample_t voiced;
+	if (this->quality == MATH_QUALITY_FAST)
+		voiced = 0.1f + 0.2f * fmaxf(0.0f, fastSin(2.0f * (float) M_PI * this->timeInWaveform / this->waveformLength));
+	else
+		voiced = 0.1 + 0.2 * fmax(0.0, sin(M_PI * 2 * this->timeInWaveform / this->waveformLength));
 	//return 0.3;
 	return this->targetTenseness * this->intensity * voiced + (1 - this->targetTenseness * this->intensity) * 0.3;
 }
@@ -109,34 +130,39 @@ void Glottis::finishBlock()
 {
 	sample_t vibrato = 0;
 	vibrato += this->vibratoAmount * sin(2 * M_PI * this->totalTime * this->vibratoFrequency);
-	vibrato += 0.02 * simplex1(this->totalTime * 4.07);
-	vibrato += 0.04 * simplex1(this->totalTime * 2.15);
+	vibrato += 0.02 * simplex1(&this->simplex, this->totalTime * 4.07);
+	vibrato += 0.04 * simplex1(&this->simplex, this->totalTime * 2.15);
 	if (this->autoWobble)
 	{
-		vibrato += 0.2 * simplex1(this->totalTime * 0.98);
-		vibrato += 0.4 * simplex1(this->totalTime * 0.5);
+		vibrato += 0.2 * simplex1(&this->simplex, this->totalTime * 0.98);
+		vibrato += 0.4 * simplex1(&this->simplex, this->totalTime * 0.5);
 	}
 	if (this->targetFrequency > this->smoothFrequency)
-		this->smoothFrequency = fmin(this->smoothFrequency * 1.1, this->targetFrequency);
+		this->smoothFrequency = fmin(this->smoothFrequency * this->frequencyStep, this->targetFrequency);
 	if (this->targetFrequency < this->smoothFrequency)
-		this->smoothFrequency = fmax(this->smoothFrequency / 1.1, this->targetFrequency);
+		this->smoothFrequency = fmax(this->smoothFrequency / this->frequencyStep, this->targetFrequency);
 	this->oldFrequency = this->newFrequency;
 	this->newFrequency = this->smoothFrequency * (1 + vibrato);
 	this->oldTenseness = this->newTenseness;
 	this->newTenseness = this->targetTenseness +
-		0.1 * simplex1(this->totalTime * 0.46) + 0.05 * simplex1(this->totalTime * 0.36);
+		0.1 * simplex1(&this->simplex, this->totalTime * 0.46) + 0.05 * simplex1(&this->simplex, this->totalTime * 0.36);
 	if (!this->isTouched && alwaysVoice) this->newTenseness += (3-this->targetTenseness)*(1-this->intensity);
 	
-	if (this->isTouched || alwaysVoice) this->intensity += 0.13;
-	else this->intensity -= 0.05;
+	if (this->isTouched || alwaysVoice) this->intensity += 0.13 * this->blockScale;
+	else this->intensity -= 0.05 * this->blockScale;
 	this->intensity = clamp(this->intensity, 0.0, 1.0);
 }
 
 sample_t Glottis::normalizedLFWaveform(sample_t t)
 {
 	sample_t output;
-	if (t > this->Te) output = (-exp(-this->epsilon * (t - this->Te)) + this->shift) / this->Delta;
-	else output = this->E0 * exp(this->alpha * t) * sin(this->omega * t);
+	if (this->quality == MATH_QUALITY_FAST) {
+		if (t > this->Te) output = (-fastExp(-this->epsilon * (t - this->Te)) + this->shift) / this->Delta;
+		else output = this->E0 * fastExp(this->alpha * t) * fastSin(this->omega * t);
+	} else {
+		if (t > this->Te) output = (-exp(-this->epsilon * (t - this->Te)) + this->shift) / this->Delta;
+		else output = this->E0 * exp(this->alpha * t) * sin(this->omega * t);
+	}
 	
 	return output * this->intensity * this->loudness;
 }
@@ -144,17 +170,29 @@ sample_t Glottis::normalizedLFWaveform(sample_t t)
 sample_t Glottis::runStep(sample_t lambda, sample_t noiseSource)
 {
 	
+	if (this->directFrequency > 0 && this->directFrequency != this->frequency)
+	{
+		sample_t phase = this->timeInWaveform / this->waveformLength;
+		this->frequency = this->directFrequency;
+		this->waveformLength = 1.0 / this->frequency;
+		this->timeInWaveform = phase * this->waveformLength;
+	}
 	sample_t timeStep = 1.0 / this->sampleRate;
 	this->timeInWaveform += timeStep;
-	this->totalTime += timeStep;
+	this->totalSamples++;
+	this->totalTime = this->totalSamples * this->samplePeriod;
 	if (this->timeInWaveform > this->waveformLength)
 	{
 		this->timeInWaveform -= this->waveformLength;
 		this->setupWaveform(lambda);
 	}
 	sample_t out = this->normalizedLFWaveform(this->timeInWaveform / this->waveformLength);
-	sample_t aspiration = this->intensity * (1 - sqrt(this->targetTenseness)) * this->getNoiseModulator() * noiseSource;
-	aspiration *= 0.2 + 0.02 * simplex1(this->totalTime * 1.99);
+	sample_t aspiration;
+	if (this->quality == MATH_QUALITY_FAST)
+		aspiration = this->intensity * (1.0f - sqrtf(this->targetTenseness)) * this->getNoiseModulator() * noiseSource;
+	else
+		aspiration = this->intensity * (1 - sqrt(this->targetTenseness)) * this->getNoiseModulator() * noiseSource;
+	aspiration *= 0.2 + 0.02 * simplex1(&this->simplex, this->totalTime * 1.99);
 	out += aspiration;
 	return out;
 }
@@ -9,17 +9,41 @@
 #define Glottis_h
 
 #include <stdio.h>
+#include <stdint.h>
 #include "config.h"
+#include "FastMath.h"
+#include "noise.h"
 
 class Glottis {
 public:
-	Glottis(double sampleRate);
-	~Glottis();
+	// Per-block ramps (intensity, frequency glide) are scaled so they run at
+	// the same speed in time for any blockTime
+	Glottis(double sampleRate, double blockTime = GLOTTIS_REFERENCE_BLOCK_TIME);
+	~Glottis() = default; // keeps the class trivially copyable for voice snapshots
 	sample_t runStep(sample_t lambda, sample_t noiseSource);
 	void finishBlock();
 	sample_t getNoiseModulator();
 	void setTargetFrequency(sample_t frequency); // 140
 	void setTargetTenseness(sample_t tenseness); // 0.6
+	void setMathQuality(t_mathQuality quality) { this->quality = quality; }
+	// Time between finishBlock() calls, for a caller that changes its rate
+	void setBlockTime(double blockTime);
+	// Audio-rate inputs, used from the next runStep() in place of the per-block
+	// glide, vibrato and jitter. A new frequency rescales the current period so
+	// the phase stays continuous; a new tenseness shapes the next period.
+	void setAudioRateFrequency(sample_t frequency)
+	{
+		this->directFrequency = this->targetFrequency = this->smoothFrequency = frequency;
+	}
+	void setAudioRateTenseness(sample_t tenseness)
+	{
+		this->directTenseness = this->targetTenseness = tenseness;
+	}
+	// Back to the per-block parameters, gliding on from the last inputs
+	void releaseAudioRateInputs() { this->directFrequency = this->directTenseness = -1; }
+	// Reseeds the simplex field behind vibrato, wobble and tenseness jitter,
+	// seeded from the clock by default
+	void setSeed(short seed);
     
     sample_t vibratoAmount;
     sample_t vibratoFrequency;
@@ -32,6 +56,7 @@ private:
 	sample_t timeInWaveform;
 	sample_t frequency, oldFrequency, newFrequency, smoothFrequency,targetFrequency;
 	sample_t oldTenseness, newTenseness, targetTenseness;
+	sample_t directFrequency, directTenseness;	// audio-rate inputs, negative when unused
 	sample_t waveformLength;
 	sample_t Rd;
 	sample_t alpha;
@@ -41,8 +66,13 @@ private:
 	sample_t Delta;
 	sample_t Te;
 	sample_t omega;
-	sample_t totalTime;
+	sample_t totalTime;					// derived from totalSamples, so it never drifts
+	uint64_t totalSamples;
+	double samplePeriod;
 	sample_t intensity, loudness;
+	sample_t blockScale, frequencyStep;
+	t_mathQuality quality;
+	t_simplex simplex;
 	
 	bool autoWobble;
 	bool isTouched;
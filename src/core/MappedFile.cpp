@@ -0,0 +1,207 @@
+//==============================================================================
+// src/core/MappedFile.cpp
+//==============================================================================
+
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#endif
+
+MappedFile::MappedFile()
+    : data(nullptr)
+    , size(0)
+    , writable(false)
+#ifdef _WIN32
+    , file(INVALID_HANDLE_VALUE)
+    , mapping(nullptr)
+#else
+    , fd(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile() {
+    this->close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &path) {
+    this->close();
+    this->file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (this->file == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(this->file, &fileSize) || fileSize.QuadPart == 0) {
+        this->close();
+        return false;
+    }
+    this->mapping = CreateFileMappingA(this->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (this->mapping) this->data = MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!this->data) {
+        this->close();
+        return false;
+    }
+    this->size = (size_t) fileSize.QuadPart;
+    this->writable = false;
+    return true;
+}
+
+bool MappedFile::create(const std::string &path, size_t size) {
+    this->close();
+    this->file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (this->file == INVALID_HANDLE_VALUE || size == 0) {
+        this->close();
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    fileSize.QuadPart = (LONGLONG) size;
+    this->mapping = CreateFileMappingA(this->file, NULL, PAGE_READWRITE, fileSize.HighPart, fileSize.LowPart, NULL);
+    if (this->mapping) this->data = MapViewOfFile(this->mapping, FILE_MAP_WRITE, 0, 0, 0);
+    if (!this->data) {
+        this->close();
+        return false;
+    }
+    this->size = size;
+    this->writable = true;
+    return true;
+}
+
+bool MappedFile::createShared(size_t size) {
+    this->close();
+    return false;
+}
+
+bool MappedFile::open(int descriptor) {
+    this->close();
+    return false;
+}
+
+int MappedFile::getDescriptor() const {
+    return -1;
+}
+
+void MappedFile::close() {
+    if (this->data) UnmapViewOfFile(this->data);
+    if (this->mapping) CloseHandle(this->mapping);
+    if (this->file != INVALID_HANDLE_VALUE) CloseHandle(this->file);
+    this->data = nullptr;
+    this->mapping = nullptr;
+    this->file = INVALID_HANDLE_VALUE;
+    this->size = 0;
+    this->writable = false;
+}
+
+bool MappedFile::flush() {
+    return this->writable && FlushViewOfFile(this->data, 0) && FlushFileBuffers(this->file);
+}
+
+#else
+
+bool MappedFile::open(const std::string &path) {
+    this->close();
+    this->fd = ::open(path.c_str(), O_RDONLY);
+    if (this->fd < 0) return false;
+    struct stat info;
+    if (fstat(this->fd, &info) != 0 || info.st_size == 0) {
+        this->close();
+        return false;
+    }
+    void *mapped = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_SHARED, this->fd, 0);
+    if (mapped == MAP_FAILED) {
+        this->close();
+        return false;
+    }
+    // Fault the pages in ahead of playback
+    madvise(mapped, (size_t) info.st_size, MADV_WILLNEED);
+    this->data = mapped;
+    this->size = (size_t) info.st_size;
+    this->writable = false;
+    return true;
+}
+
+bool MappedFile::create(const std::string &path, size_t size) {
+    this->close();
+    this->fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (this->fd < 0 || size == 0 || ftruncate(this->fd, (off_t) size) != 0) {
+        this->close();
+        return false;
+    }
+    void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if (mapped == MAP_FAILED) {
+        this->close();
+        return false;
+    }
+    this->data = mapped;
+    this->size = size;
+    this->writable = true;
+    return true;
+}
+
+bool MappedFile::createShared(size_t size) {
+    this->close();
+    if (size == 0) return false;
+    // The name only lives until shm_unlink(); the descriptor keeps the memory
+    static std::atomic<unsigned> counter(0);
+    std::string name = "/ofxpt-" + std::to_string(getpid()) + "-" + std::to_string(counter++);
+    this->fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (this->fd < 0) return false;
+    shm_unlink(name.c_str());
+    if (ftruncate(this->fd, (off_t) size) != 0) {
+        this->close();
+        return false;
+    }
+    void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if (mapped == MAP_FAILED) {
+        this->close();
+        return false;
+    }
+    this->data = mapped;
+    this->size = size;
+    this->writable = true;
+    return true;
+}
+
+bool MappedFile::open(int descriptor) {
+    this->close();
+    this->fd = descriptor;
+    struct stat info;
+    if (this->fd < 0 || fstat(this->fd, &info) != 0 || info.st_size == 0) {
+        this->close();
+        return false;
+    }
+    void *mapped = mmap(nullptr, (size_t) info.st_size, PROT_READ, MAP_SHARED, this->fd, 0);
+    if (mapped == MAP_FAILED) {
+        this->close();
+        return false;
+    }
+    this->data = mapped;
+    this->size = (size_t) info.st_size;
+    this->writable = false;
+    return true;
+}
+
+int MappedFile::getDescriptor() const {
+    return this->fd;
+}
+
+void MappedFile::close() {
+    if (this->data) munmap(this->data, this->size);
+    if (this->fd >= 0) ::close(this->fd);
+    this->data = nullptr;
+    this->fd = -1;
+    this->size = 0;
+    this->writable = false;
+}
+
+bool MappedFile::flush() {
+    return this->writable && msync(this->data, this->size, MS_SYNC) == 0;
+}
+
+#endif
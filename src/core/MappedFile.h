@@ -0,0 +1,51 @@
+//==============================================================================
+// src/core/MappedFile.h
+// Memory-mapped file, read-only or created read-write at a fixed size
+//==============================================================================
+
+#ifndef MappedFile_h
+#define MappedFile_h
+
+#include <stddef.h>
+#include <string>
+
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    // Maps an existing file read-only
+    bool open(const std::string &path);
+    // Creates (or truncates) a file of the given size and maps it read-write
+    bool create(const std::string &path, size_t size);
+    // POSIX only: nameless shared memory of the given size, mapped read-write,
+    // whose descriptor can be passed to another process
+    bool createShared(size_t size);
+    // POSIX only: maps a descriptor read-only and takes ownership of it
+    bool open(int descriptor);
+    int getDescriptor() const;
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    const void *getData() const { return data; }
+    void *getWritableData() { return writable ? data : nullptr; }
+    size_t getSize() const { return size; }
+
+    // Writes dirty pages back to disk (read-write mappings only)
+    bool flush();
+
+private:
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    void *data;
+    size_t size;
+    bool writable;
+#ifdef _WIN32
+    void *file, *mapping;
+#else
+    int fd;
+#endif
+};
+
+#endif /* MappedFile_h */
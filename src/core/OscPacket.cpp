@@ -0,0 +1,233 @@
+//==============================================================================
+// src/core/OscPacket.cpp
+//==============================================================================
+
+#include "OscPacket.h"
+#include <chrono>
+#include <cmath>
+#include <string.h>
+
+// Seconds from the NTP epoch (1900) to the Unix epoch (1970)
+#define NTP_UNIX_OFFSET (2208988800.0)
+
+// Top-level bundles have no size word to patch
+#define NO_SIZE_WORD    ((size_t) -1)
+
+static uint32_t readWord(const unsigned char *p) {
+    return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
+}
+
+static uint64_t readLong(const unsigned char *p) {
+    return (uint64_t) readWord(p) << 32 | readWord(p + 4);
+}
+
+// Length of a padded string starting at p, or 0 if it runs past end
+static size_t paddedLength(const unsigned char *p, const unsigned char *end) {
+    const unsigned char *terminator = (const unsigned char *) memchr(p, 0, end - p);
+    if (!terminator) return 0;
+    size_t length = (terminator - p + 4) & ~(size_t) 3;
+    return length <= (size_t) (end - p) ? length : 0;
+}
+
+uint64_t oscTimeFromSeconds(double secondsSince1970) {
+    double seconds = secondsSince1970 + NTP_UNIX_OFFSET;
+    double whole = (double) (uint64_t) seconds;
+    return (uint64_t) whole << 32 | (uint64_t) ((seconds - whole) * 4294967296.0);
+}
+
+double oscTimeToSeconds(uint64_t timetag) {
+    return (double) (timetag >> 32) - NTP_UNIX_OFFSET + (double) (timetag & 0xffffffffu) / 4294967296.0;
+}
+
+uint64_t oscTimeNow() {
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    return oscTimeFromSeconds(std::chrono::duration<double>(now).count());
+}
+
+//==============================================================================
+
+double OscMessage::getNumber(int i) const {
+    if (i >= this->count) return 0;
+    const unsigned char *p = this->arguments[i];
+    switch (this->types[i]) {
+        case 'i': return (int32_t) readWord(p);
+        case 'h': return (double) (int64_t) readLong(p);
+        case 'f': {
+            uint32_t bits = readWord(p);
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        case 'd': {
+            uint64_t bits = readLong(p);
+            double value;
+            memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+        case 'T': return 1;
+        default: return 0;
+    }
+}
+
+float OscMessage::getFloat(int i) const {
+    return (float) this->getNumber(i);
+}
+
+int32_t OscMessage::getInt(int i) const {
+    char type = this->getType(i);
+    if (type == 'f' || type == 'd') return (int32_t) std::lround(this->getNumber(i));
+    return (int32_t) this->getNumber(i);
+}
+
+const char *OscMessage::getString(int i) const {
+    char type = this->getType(i);
+    return type == 's' || type == 'S' ? (const char *) this->arguments[i] : "";
+}
+
+//==============================================================================
+
+bool OscParser::parse(const void *data, size_t size, const Handler &handler) {
+    return parseElement((const unsigned char *) data, size, OSC_IMMEDIATELY, 0, handler);
+}
+
+bool OscParser::parseElement(const unsigned char *data, size_t size, uint64_t timetag,
+                             int depth, const Handler &handler) {
+    if (size < 4 || size % 4 != 0) return false;
+    if (data[0] == '/') return parseMessage(data, size, timetag, handler);
+    if (size < 16 || memcmp(data, "#bundle", 8) != 0 || depth >= OSC_MAX_DEPTH) return false;
+
+    timetag = readLong(data + 8);
+    for (size_t p = 16; p < size; ) {
+        if (size - p < 4) return false;
+        size_t length = readWord(data + p);
+        p += 4;
+        if (length > size - p || !parseElement(data + p, length, timetag, depth + 1, handler)) return false;
+        p += length;
+    }
+    return true;
+}
+
+bool OscParser::parseMessage(const unsigned char *data, size_t size, uint64_t timetag,
+                             const Handler &handler) {
+    const unsigned char *end = data + size;
+    OscMessage message;
+    message.address = (const char *) data;
+    size_t length = paddedLength(data, end);
+    if (length == 0) return false;
+    const unsigned char *p = data + length;
+
+    // The type tag string may be missing in messages from old senders
+    message.count = 0;
+    message.types = "";
+    if (p < end && *p == ',') {
+        length = paddedLength(p, end);
+        if (length == 0) return false;
+        message.types = (const char *) p + 1;
+        p += length;
+    }
+
+    for (const char *t = message.types; *t; t++) {
+        const unsigned char *argument = p;
+        switch (*t) {
+            case 'i': case 'f': case 'c': case 'r': case 'm':
+                p += 4;
+                break;
+            case 'h': case 'd': case 't':
+                p += 8;
+                break;
+            case 's': case 'S':
+                length = paddedLength(p, end);
+                if (length == 0) return false;
+                p += length;
+                break;
+            case 'b':
+                if (end - p < 4) return false;
+                length = 4 + (((size_t) readWord(p) + 3) & ~(size_t) 3);
+                if (length > (size_t) (end - p)) return false;
+                p += length;
+                break;
+            case 'T': case 'F': case 'N': case 'I': case '[': case ']':
+                break;
+            default:
+                return false;
+        }
+        if (p > end) return false;
+        if (message.count < OSC_MAX_ARGUMENTS) message.arguments[message.count++] = argument;
+    }
+    handler(message, timetag);
+    return true;
+}
+
+//==============================================================================
+
+void OscWriter::clear() {
+    this->data.clear();
+    this->bundleStarts.clear();
+}
+
+void OscWriter::openBundle(uint64_t timetag) {
+    if (this->bundleStarts.empty()) {
+        this->bundleStarts.push_back(NO_SIZE_WORD);
+    } else {
+        this->bundleStarts.push_back(this->data.size());
+        this->writeWord(this->data, 0);
+    }
+    this->writeString(this->data, "#bundle");
+    this->writeWord(this->data, (uint32_t) (timetag >> 32));
+    this->writeWord(this->data, (uint32_t) timetag);
+}
+
+void OscWriter::closeBundle() {
+    if (this->bundleStarts.empty()) return;
+    size_t start = this->bundleStarts.back();
+    this->bundleStarts.pop_back();
+    if (start == NO_SIZE_WORD) return;
+    uint32_t length = (uint32_t) (this->data.size() - start - 4);
+    for (int i = 0; i < 4; i++) this->data[start + i] = (unsigned char) (length >> (24 - 8 * i));
+}
+
+void OscWriter::openMessage(const std::string &address) {
+    this->address = address;
+    this->types = ",";
+    this->arguments.clear();
+}
+
+void OscWriter::addInt(int32_t value) {
+    this->types += 'i';
+    this->writeWord(this->arguments, (uint32_t) value);
+}
+
+void OscWriter::addFloat(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    this->types += 'f';
+    this->writeWord(this->arguments, bits);
+}
+
+void OscWriter::addString(const std::string &value) {
+    this->types += 's';
+    this->writeString(this->arguments, value);
+}
+
+void OscWriter::closeMessage() {
+    size_t start = this->data.size();
+    bool inBundle = !this->bundleStarts.empty();
+    if (inBundle) this->writeWord(this->data, 0);
+    this->writeString(this->data, this->address);
+    this->writeString(this->data, this->types);
+    this->data.insert(this->data.end(), this->arguments.begin(), this->arguments.end());
+    if (inBundle) {
+        uint32_t length = (uint32_t) (this->data.size() - start - 4);
+        for (int i = 0; i < 4; i++) this->data[start + i] = (unsigned char) (length >> (24 - 8 * i));
+    }
+}
+
+void OscWriter::writeString(std::vector<unsigned char> &out, const std::string &value) {
+    out.insert(out.end(), value.begin(), value.end());
+    size_t padding = 4 - value.size() % 4;
+    out.insert(out.end(), padding, 0);
+}
+
+void OscWriter::writeWord(std::vector<unsigned char> &out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back((unsigned char) (value >> (24 - 8 * i)));
+}
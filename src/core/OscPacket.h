@@ -0,0 +1,94 @@
+//==============================================================================
+// src/core/OscPacket.h
+// Open Sound Control 1.0 packets: in-place parsing of messages and bundles,
+// and a writer that builds them
+//==============================================================================
+
+#ifndef OscPacket_h
+#define OscPacket_h
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define OSC_MAX_ARGUMENTS   (16)    // further arguments of a message are ignored
+#define OSC_MAX_DEPTH       (8)     // of nested bundles
+#define OSC_IMMEDIATELY     (1ull)  // timetag of bundles to run on arrival
+
+// OSC time: NTP seconds since 1900 in the high 32 bits, fraction in the low
+uint64_t oscTimeFromSeconds(double secondsSince1970);
+double oscTimeToSeconds(uint64_t timetag);
+uint64_t oscTimeNow();
+
+// One message of a packet, pointing into the packet's bytes. Numeric getters
+// convert between the int32 (i), float32 (f), int64 (h), float64 (d) and
+// boolean (T, F) types and return 0 for anything else.
+class OscMessage {
+public:
+    const char *getAddress() const { return address; }
+    int getArgumentCount() const { return count; }
+    char getType(int i) const { return i < count ? types[i] : 0; }
+    float getFloat(int i) const;
+    int32_t getInt(int i) const;
+    // Empty unless the argument is a string (s) or symbol (S)
+    const char *getString(int i) const;
+
+private:
+    friend class OscParser;
+    double getNumber(int i) const;
+
+    const char *address;
+    const char *types;
+    const unsigned char *arguments[OSC_MAX_ARGUMENTS];
+    int count;
+};
+
+// Splits a packet into its messages. Each message is handed over with the
+// timetag of the innermost bundle holding it, or OSC_IMMEDIATELY. Returns
+// false on a malformed packet; messages before the fault have been handed over.
+class OscParser {
+public:
+    typedef std::function<void(const OscMessage &message, uint64_t timetag)> Handler;
+
+    static bool parse(const void *data, size_t size, const Handler &handler);
+
+private:
+    static bool parseElement(const unsigned char *data, size_t size, uint64_t timetag,
+                             int depth, const Handler &handler);
+    static bool parseMessage(const unsigned char *data, size_t size, uint64_t timetag,
+                             const Handler &handler);
+};
+
+// Builds one packet: a message, or a bundle of messages and bundles
+//   writer.openBundle(oscTimeFromSeconds(t));
+//   writer.openMessage("/voice/0/frequency");
+//   writer.addFloat(220.0f);
+//   writer.closeMessage();
+//   writer.closeBundle();
+class OscWriter {
+public:
+    void clear();
+    void openBundle(uint64_t timetag);
+    void closeBundle();
+    void openMessage(const std::string &address);
+    void addInt(int32_t value);
+    void addFloat(float value);
+    void addString(const std::string &value);
+    void closeMessage();
+
+    const void *getData() const { return data.data(); }
+    size_t getSize() const { return data.size(); }
+
+private:
+    void writeString(std::vector<unsigned char> &out, const std::string &value);
+    void writeWord(std::vector<unsigned char> &out, uint32_t value);
+
+    std::vector<unsigned char> data;
+    std::vector<size_t> bundleStarts;   // of each open bundle's element size
+    std::string address, types;
+    std::vector<unsigned char> arguments;
+};
+
+#endif /* OscPacket_h */
@@ -0,0 +1,202 @@
+//==============================================================================
+// src/core/Profiler.cpp
+//==============================================================================
+
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+static const struct {
+    const char *name;
+    int parent;
+} stages[NUM_PROFILE_STAGES] = {
+    { "block", -1 },
+    { "control", PROFILE_BLOCK },
+    { "noise", PROFILE_BLOCK },
+    { "glottis", PROFILE_BLOCK },
+    { "tract", PROFILE_BLOCK },
+    { "transients", PROFILE_TRACT },
+    { "turbulence", PROFILE_TRACT },
+    { "scattering", PROFILE_TRACT },
+    { "nose", PROFILE_TRACT },
+    { "finish block", PROFILE_BLOCK },
+    { "reshape", PROFILE_FINISH }
+};
+
+Profiler::Profiler(const std::string &name)
+    : name(name) {
+    this->reset();
+}
+
+double Profiler::getTicksPerSecond() {
+#ifdef PROFILER_RDTSC
+    // Counted against steady_clock over 20 ms, once
+    static const double ticksPerSecond = [] {
+        typedef std::chrono::steady_clock clock;
+        clock::time_point start = clock::now();
+        uint64_t startTicks = now();
+        while (clock::now() - start < std::chrono::milliseconds(20)) {}
+        double seconds = std::chrono::duration<double>(clock::now() - start).count();
+        return (now() - startTicks) / seconds;
+    }();
+    return ticksPerSecond;
+#else
+    return 1e9;
+#endif
+}
+
+const char *Profiler::getStageName(t_profileStage stage) {
+    return stages[stage].name;
+}
+
+int Profiler::getStageParent(t_profileStage stage) {
+    return stages[stage].parent;
+}
+
+void Profiler::reset() {
+    this->blockStart = 0;
+    this->blockFrames = 0;
+    for (int s = 0; s < NUM_PROFILE_STAGES; s++) {
+        this->blockTicks[s] = 0;
+        this->blockCalls[s] = 0;
+        this->totalTicks[s] = 0;
+        this->maxTicks[s] = 0;
+        this->totalCalls[s] = 0;
+    }
+    this->blockCount = 0;
+    for (int i = 0; i < PROFILE_HISTORY_BLOCKS; i++) this->history[i].index = UINT64_MAX;
+}
+
+void Profiler::beginBlock(int numFrames) {
+    for (int s = 0; s < NUM_PROFILE_STAGES; s++) {
+        this->blockTicks[s] = 0;
+        this->blockCalls[s] = 0;
+    }
+    this->blockFrames = numFrames;
+    this->blockStart = now();
+}
+
+void Profiler::endBlock() {
+    this->add(PROFILE_BLOCK, now() - this->blockStart);
+
+    uint64_t index = this->blockCount.load(std::memory_order_relaxed);
+    BlockRecord &record = this->history[index & (PROFILE_HISTORY_BLOCKS - 1)];
+    // Invalidate the slot while it is rewritten, so readers skip it
+    record.index.store(UINT64_MAX, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    record.start.store(this->blockStart, std::memory_order_relaxed);
+    record.frames.store((uint32_t) this->blockFrames, std::memory_order_relaxed);
+    for (int s = 0; s < NUM_PROFILE_STAGES; s++) {
+        uint64_t ticks = this->blockTicks[s];
+        record.ticks[s].store(ticks, std::memory_order_relaxed);
+        this->totalTicks[s].store(this->totalTicks[s].load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+        this->totalCalls[s].store(this->totalCalls[s].load(std::memory_order_relaxed) + this->blockCalls[s], std::memory_order_relaxed);
+        if (ticks > this->maxTicks[s].load(std::memory_order_relaxed)) {
+            this->maxTicks[s].store(ticks, std::memory_order_relaxed);
+        }
+    }
+    record.index.store(index, std::memory_order_release);
+    this->blockCount.store(index + 1, std::memory_order_release);
+}
+
+Profiler::t_stageTotals Profiler::getTotals(t_profileStage stage) const {
+    double tickSeconds = 1.0 / getTicksPerSecond();
+    uint64_t blocks = this->getBlockCount();
+    t_stageTotals totals;
+    totals.seconds = this->totalTicks[stage].load(std::memory_order_relaxed) * tickSeconds;
+    totals.meanBlockSeconds = blocks > 0 ? totals.seconds / blocks : 0;
+    totals.maxBlockSeconds = this->maxTicks[stage].load(std::memory_order_relaxed) * tickSeconds;
+    totals.calls = this->totalCalls[stage].load(std::memory_order_relaxed);
+    return totals;
+}
+
+std::string Profiler::getSummary() const {
+    t_stageTotals block = this->getTotals(PROFILE_BLOCK);
+    std::ostringstream out;
+    out << this->name << ": " << this->getBlockCount() << " blocks\n";
+    out << std::left << std::setw(20) << "stage" << std::right
+        << std::setw(12) << "total ms" << std::setw(9) << "share"
+        << std::setw(14) << "mean us/blk" << std::setw(13) << "max us/blk"
+        << std::setw(14) << "calls" << "\n";
+    for (int s = 0; s < NUM_PROFILE_STAGES; s++) {
+        t_stageTotals t = this->getTotals((t_profileStage) s);
+        int depth = 0;
+        for (int p = stages[s].parent; p >= 0; p = stages[p].parent) depth++;
+        std::string label = std::string(2 * depth, ' ') + stages[s].name;
+        out << std::left << std::setw(20) << label << std::right << std::fixed
+            << std::setw(12) << std::setprecision(3) << t.seconds * 1e3
+            << std::setw(8) << std::setprecision(1) << (block.seconds > 0 ? 100 * t.seconds / block.seconds : 0) << "%"
+            << std::setw(14) << std::setprecision(2) << t.meanBlockSeconds * 1e6
+            << std::setw(13) << std::setprecision(2) << t.maxBlockSeconds * 1e6
+            << std::setw(14) << t.calls << "\n";
+    }
+    return out.str();
+}
+
+bool Profiler::writeChromeTrace(const std::string &path, const std::vector<const Profiler *> &profilers) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) return false;
+
+    double microsPerTick = 1e6 / getTicksPerSecond();
+    uint64_t origin = UINT64_MAX;
+    for (const Profiler *p : profilers) {
+        for (int i = 0; i < PROFILE_HISTORY_BLOCKS; i++) {
+            if (p->history[i].index.load(std::memory_order_acquire) != UINT64_MAX) {
+                origin = std::min(origin, p->history[i].start.load(std::memory_order_relaxed));
+            }
+        }
+    }
+
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    auto event = [&](int tid, const char *name, double ts, double dur, const char *args) {
+        out << (first ? "" : ",\n") << std::fixed << std::setprecision(3)
+            << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+            << ",\"ts\":" << ts << ",\"dur\":" << dur;
+        if (args) out << ",\"args\":{" << args << "}";
+        out << "}";
+        first = false;
+    };
+
+    for (size_t t = 0; t < profilers.size(); t++) {
+        const Profiler *p = profilers[t];
+        int tid = (int) t + 1;
+        out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"" << p->name << "\"}}";
+        first = false;
+
+        uint64_t count = p->getBlockCount();
+        uint64_t begin = count > PROFILE_HISTORY_BLOCKS ? count - PROFILE_HISTORY_BLOCKS : 0;
+        for (uint64_t index = begin; index < count; index++) {
+            const BlockRecord &r = p->history[index & (PROFILE_HISTORY_BLOCKS - 1)];
+            uint64_t ticks[NUM_PROFILE_STAGES];
+            uint64_t start = r.start.load(std::memory_order_relaxed);
+            uint32_t frames = r.frames.load(std::memory_order_relaxed);
+            for (int s = 0; s < NUM_PROFILE_STAGES; s++) ticks[s] = r.ticks[s].load(std::memory_order_relaxed);
+            // Skip slots the audio thread rewrote while they were read
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (r.index.load(std::memory_order_relaxed) != index) continue;
+
+            // Lay each stage's children end to end from the stage's start
+            double stageStart[NUM_PROFILE_STAGES];
+            double nextChild[NUM_PROFILE_STAGES];
+            for (int s = 0; s < NUM_PROFILE_STAGES; s++) {
+                int parent = stages[s].parent;
+                stageStart[s] = parent < 0 ? (start - origin) * microsPerTick : nextChild[parent];
+                nextChild[s] = stageStart[s];
+                if (parent >= 0) nextChild[parent] += ticks[s] * microsPerTick;
+                if (s == PROFILE_BLOCK) {
+                    std::string args = "\"block\":" + std::to_string(index) + ",\"frames\":" + std::to_string(frames);
+                    event(tid, stages[s].name, stageStart[s], ticks[s] * microsPerTick, args.c_str());
+                } else if (ticks[s] > 0) {
+                    event(tid, stages[s].name, stageStart[s], ticks[s] * microsPerTick, nullptr);
+                }
+            }
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return (bool) out;
+}
@@ -0,0 +1,145 @@
+//==============================================================================
+// src/core/Profiler.h
+// Per-stage render timers, aggregated per block and read lock-free
+//==============================================================================
+
+#ifndef Profiler_h
+#define Profiler_h
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "config.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define PROFILER_RDTSC 1
+#else
+#include <chrono>
+#endif
+
+typedef enum t_profileStage {
+    PROFILE_BLOCK,          // all of PinkTrombone::synthesize()
+    PROFILE_CONTROL,        // parameter smoothing and area-function blending
+    PROFILE_NOISE,          // white noise and the fricative filter
+    PROFILE_GLOTTIS,
+    PROFILE_TRACT,          // Tract::runStep()
+    PROFILE_TRANSIENTS,
+    PROFILE_TURBULENCE,
+    PROFILE_SCATTERING,     // oral junctions and the nose junction
+    PROFILE_NOSE,           // nasal waveguide
+    PROFILE_FINISH,         // end of a control block
+    PROFILE_RESHAPE,        // Tract::finishBlock()
+    NUM_PROFILE_STAGES
+} t_profileStage;
+
+#define PROFILE_HISTORY_BLOCKS  (1024)  // blocks kept for the trace, a power of two
+
+// Written by the audio thread only: stage times are summed in plain counters
+// during a block and published by endBlock(), into running totals and into a
+// ring of the last PROFILE_HISTORY_BLOCKS blocks that any thread can read.
+// Time comes from the TSC on x86 and steady_clock elsewhere. Each scope costs
+// two clock reads, so per-sample stages add noticeable time of their own;
+// compare stages against each other rather than against unprofiled builds.
+class Profiler {
+public:
+    typedef struct t_stageTotals {
+        double seconds;             // since the last reset
+        double meanBlockSeconds;
+        double maxBlockSeconds;
+        uint64_t calls;
+    } t_stageTotals;
+
+    Profiler(const std::string &name);
+
+    static inline uint64_t now() {
+#ifdef PROFILER_RDTSC
+        return __rdtsc();
+#else
+        return (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+    // Measured once, on first use; call it off the audio thread first
+    static double getTicksPerSecond();
+    static const char *getStageName(t_profileStage stage);
+    // Stage that encloses this one, or -1
+    static int getStageParent(t_profileStage stage);
+
+    // Audio thread
+    void beginBlock(int numFrames);
+    void endBlock();
+    void add(t_profileStage stage, uint64_t ticks) {
+        this->blockTicks[stage] += ticks;
+        this->blockCalls[stage]++;
+    }
+
+    // Any thread
+    const std::string &getName() const { return name; }
+    uint64_t getBlockCount() const { return blockCount.load(std::memory_order_acquire); }
+    t_stageTotals getTotals(t_profileStage stage) const;
+    // Table of every stage, children indented under their parent
+    std::string getSummary() const;
+
+    // Chrome trace JSON (chrome://tracing, Perfetto) of the blocks still in
+    // each profiler's history, one thread row per profiler. Stages interleave
+    // per sample, so inside each block they are drawn end to end, with their
+    // summed durations, nested under their parent stage.
+    static bool writeChromeTrace(const std::string &path, const std::vector<const Profiler *> &profilers);
+    bool writeChromeTrace(const std::string &path) const { return writeChromeTrace(path, { this }); }
+
+    void reset();   // not safe while the audio thread is rendering
+
+private:
+    struct BlockRecord {
+        std::atomic<uint64_t> index;
+        std::atomic<uint64_t> start;
+        std::atomic<uint32_t> frames;
+        std::atomic<uint64_t> ticks[NUM_PROFILE_STAGES];
+    };
+
+    std::string name;
+
+    // Audio thread
+    uint64_t blockStart;
+    int blockFrames;
+    uint64_t blockTicks[NUM_PROFILE_STAGES];
+    uint32_t blockCalls[NUM_PROFILE_STAGES];
+
+    std::atomic<uint64_t> totalTicks[NUM_PROFILE_STAGES];
+    std::atomic<uint64_t> maxTicks[NUM_PROFILE_STAGES];
+    std::atomic<uint64_t> totalCalls[NUM_PROFILE_STAGES];
+    std::atomic<uint64_t> blockCount;
+    BlockRecord history[PROFILE_HISTORY_BLOCKS];
+};
+
+// Times the enclosing scope into stage; does nothing without a profiler
+class ProfileScope {
+public:
+    ProfileScope(Profiler *profiler, t_profileStage stage)
+        : profiler(profiler), stage(stage), start(profiler ? Profiler::now() : 0) {}
+    ~ProfileScope() {
+        if (profiler) profiler->add(stage, Profiler::now() - start);
+    }
+
+private:
+    Profiler *profiler;
+    t_profileStage stage;
+    uint64_t start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+#ifdef PINK_TROMBONE_PROFILE
+#define PROFILE_SCOPE(profiler, stage) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(profiler, stage)
+#else
+#define PROFILE_SCOPE(profiler, stage)
+#endif
+
+#endif /* Profiler_h */
@@ -0,0 +1,50 @@
+//==============================================================================
+// src/core/Random.h
+// Small seedable generator for the synthesis noise
+//==============================================================================
+
+#ifndef Random_h
+#define Random_h
+
+#include <stdint.h>
+#include "config.h"
+
+// xorshift32. Plain data, so a generator inside a component is copied along
+// with the rest of its state in voice snapshots, and unlike rand() it is never
+// shared between voices or threads.
+typedef struct t_random {
+    uint32_t state;
+} t_random;
+
+// Scrambles seed (splitmix32 finalizer), so nearby seeds give unrelated
+// sequences; the state is never zero
+static inline uint32_t randomMix(uint32_t seed)
+{
+    seed += 0x9e3779b9u;
+    seed = (seed ^ (seed >> 16)) * 0x85ebca6bu;
+    seed = (seed ^ (seed >> 13)) * 0xc2b2ae35u;
+    seed ^= seed >> 16;
+    return seed ? seed : 0x6d2b79f5u;
+}
+
+static inline void randomSeed(t_random *random, uint32_t seed)
+{
+    random->state = randomMix(seed);
+}
+
+static inline uint32_t randomNext(t_random *random)
+{
+    uint32_t x = random->state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return random->state = x;
+}
+
+// Uniform in [0, 1)
+static inline sample_t randomUnit(t_random *random)
+{
+    return (sample_t) ((randomNext(random) >> 8) * (1.0 / 16777216.0));
+}
+
+#endif /* Random_h */
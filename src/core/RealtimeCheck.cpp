@@ -0,0 +1,178 @@
+//==============================================================================
+// src/core/RealtimeCheck.cpp
+//==============================================================================
+
+#include "RealtimeCheck.h"
+#include <atomic>
+#include <string.h>
+
+#if defined(PINK_TROMBONE_REALTIME_CHECK) && defined(__GLIBC__)
+#define REALTIME_INTERPOSE 1
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Initial-exec TLS so that reading these from inside malloc never allocates
+#if defined(__GNUC__)
+#define REALTIME_TLS __thread __attribute__((tls_model("initial-exec")))
+#else
+#define REALTIME_TLS thread_local
+#endif
+
+static REALTIME_TLS int audioDepth = 0;
+static REALTIME_TLS int allowDepth = 0;
+static std::atomic<long> violationCount(0);
+
+RealtimeCheck::Scope::Scope() {
+    audioDepth++;
+}
+
+RealtimeCheck::Scope::~Scope() {
+    audioDepth--;
+}
+
+RealtimeCheck::Allow::Allow() {
+    allowDepth++;
+}
+
+RealtimeCheck::Allow::~Allow() {
+    allowDepth--;
+}
+
+bool RealtimeCheck::isAudioThread() {
+    return audioDepth > 0;
+}
+
+long RealtimeCheck::getViolationCount() {
+    return violationCount.load(std::memory_order_relaxed);
+}
+
+void RealtimeCheck::resetViolationCount() {
+    violationCount.store(0, std::memory_order_relaxed);
+}
+
+#ifdef REALTIME_INTERPOSE
+
+// Raw write to stderr that bypasses our own interposed write()
+static void reportRaw(const char *text) {
+    ssize_t r;
+    do {
+        r = syscall(SYS_write, STDERR_FILENO, text, strlen(text));
+    } while (r < 0 && errno == EINTR);
+}
+
+void RealtimeCheck::assertNotRealtime(const char *function) {
+    if (audioDepth <= 0 || allowDepth > 0) return;
+    violationCount.fetch_add(1, std::memory_order_relaxed);
+
+    // Everything below may itself allocate or write, so allow it
+    Allow allow;
+    reportRaw("[RealtimeCheck] ");
+    reportRaw(function);
+    reportRaw(" called on the audio thread\n");
+    void *frames[64];
+    int count = backtrace(frames, 64);
+    backtrace_symbols_fd(frames, count, STDERR_FILENO);
+}
+
+#else
+
+void RealtimeCheck::assertNotRealtime(const char *function) {
+    (void) function;
+    if (audioDepth <= 0 || allowDepth > 0) return;
+    violationCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+#endif
+
+//==============================================================================
+// Interposed functions (glibc only)
+//==============================================================================
+
+#ifdef REALTIME_INTERPOSE
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+    RealtimeCheck::assertNotRealtime("malloc");
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    RealtimeCheck::assertNotRealtime("calloc");
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    RealtimeCheck::assertNotRealtime("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) {
+    if (ptr) RealtimeCheck::assertNotRealtime("free");
+    __libc_free(ptr);
+}
+
+#define REALTIME_NEXT(name) \
+    static decltype(&name) next = nullptr; \
+    if (!next) next = (decltype(&name)) dlsym(RTLD_NEXT, #name)
+
+ssize_t write(int fd, const void *buf, size_t count) {
+    RealtimeCheck::assertNotRealtime("write");
+    REALTIME_NEXT(write);
+    return next(fd, buf, count);
+}
+
+size_t fwrite(const void *ptr, size_t size, size_t count, FILE *stream) {
+    RealtimeCheck::assertNotRealtime("fwrite");
+    REALTIME_NEXT(fwrite);
+    return next(ptr, size, count, stream);
+}
+
+int fputs(const char *s, FILE *stream) {
+    RealtimeCheck::assertNotRealtime("fputs");
+    REALTIME_NEXT(fputs);
+    return next(s, stream);
+}
+
+int fputc(int c, FILE *stream) {
+    RealtimeCheck::assertNotRealtime("fputc");
+    REALTIME_NEXT(fputc);
+    return next(c, stream);
+}
+
+int putc(int c, FILE *stream) {
+    RealtimeCheck::assertNotRealtime("putc");
+    REALTIME_NEXT(putc);
+    return next(c, stream);
+}
+
+int puts(const char *s) {
+    RealtimeCheck::assertNotRealtime("puts");
+    REALTIME_NEXT(puts);
+    return next(s);
+}
+
+int fflush(FILE *stream) {
+    RealtimeCheck::assertNotRealtime("fflush");
+    REALTIME_NEXT(fflush);
+    return next(stream);
+}
+
+int pthread_mutex_lock(pthread_mutex_t *mutex) {
+    RealtimeCheck::assertNotRealtime("pthread_mutex_lock");
+    REALTIME_NEXT(pthread_mutex_lock);
+    return next(mutex);
+}
+}
+
+#endif
@@ -0,0 +1,48 @@
+//==============================================================================
+// src/core/RealtimeCheck.h
+// Debug checker for blocking calls made from the audio thread
+//==============================================================================
+
+#ifndef RealtimeCheck_h
+#define RealtimeCheck_h
+
+#include "config.h"
+
+// When PINK_TROMBONE_REALTIME_CHECK is defined (see config.h), the thread
+// running PinkTrombone::synthesize is marked as the audio thread, and calls to
+// malloc/calloc/realloc/free, write and the stdio output functions, and
+// pthread_mutex_lock made from it are reported on stderr with a backtrace.
+// Interposition is only available on glibc; on other platforms the scope is
+// still tracked and RealtimeCheck::assertNotRealtime() can be called by hand.
+class RealtimeCheck {
+public:
+    // Marks the calling thread as the audio thread for the lifetime of the scope
+    class Scope {
+    public:
+        Scope();
+        ~Scope();
+    };
+
+    // Temporarily allows blocking calls on the audio thread (e.g. inside the
+    // checker's own reporting, or around a known and accepted allocation)
+    class Allow {
+    public:
+        Allow();
+        ~Allow();
+    };
+
+    static bool isAudioThread();
+    static long getViolationCount();
+    static void resetViolationCount();
+
+    // Report a violation if called from the audio thread
+    static void assertNotRealtime(const char *function);
+};
+
+#ifdef PINK_TROMBONE_REALTIME_CHECK
+#define REALTIME_SCOPE() RealtimeCheck::Scope realtimeScope__
+#else
+#define REALTIME_SCOPE()
+#endif
+
+#endif /* RealtimeCheck_h */
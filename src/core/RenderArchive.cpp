@@ -0,0 +1,151 @@
+//==============================================================================
+// src/core/RenderArchive.cpp
+//==============================================================================
+
+#include "RenderArchive.h"
+#include <stdint.h>
+
+static uint64_t alignUp(uint64_t offset) {
+    return (offset + RENDER_ARCHIVE_ALIGNMENT - 1) & ~(uint64_t) (RENDER_ARCHIVE_ALIGNMENT - 1);
+}
+
+// Moves offset past count items of itemSize bytes and aligns it; false if
+// that overflows
+static bool advance(uint64_t &offset, uint64_t count, uint64_t itemSize) {
+    uint64_t bytes, end;
+    if (__builtin_mul_overflow(count, itemSize, &bytes)
+        || __builtin_add_overflow(offset, bytes, &end)
+        || end > UINT64_MAX - RENDER_ARCHIVE_ALIGNMENT) {
+        return false;
+    }
+    offset = alignUp(end);
+    return true;
+}
+
+RenderArchive::RenderArchive()
+    : header(nullptr)
+    , index(nullptr) {
+}
+
+bool RenderArchive::create(const std::string &path, int sampleRate, int channelCount,
+                           const std::vector<uint64_t> &frameCounts) {
+    this->close();
+    if (sampleRate <= 0 || channelCount <= 0) return false;
+    uint64_t size = getSize(channelCount, frameCounts);
+    if (size == 0 || !this->file.create(path, (size_t) size)) return false;
+    this->writeIndex(sampleRate, channelCount, frameCounts);
+    return true;
+}
+
+bool RenderArchive::createShared(int sampleRate, int channelCount, const std::vector<uint64_t> &frameCounts) {
+    this->close();
+    if (sampleRate <= 0 || channelCount <= 0) return false;
+    uint64_t size = getSize(channelCount, frameCounts);
+    if (size == 0 || !this->file.createShared((size_t) size)) return false;
+    this->writeIndex(sampleRate, channelCount, frameCounts);
+    return true;
+}
+
+uint64_t RenderArchive::getSize(int channelCount, const std::vector<uint64_t> &frameCounts) {
+    if (channelCount <= 0) return 0;
+    uint64_t end = sizeof(t_renderArchiveHeader);
+    if (!advance(end, frameCounts.size(), sizeof(t_renderArchiveEntry))) return 0;
+    for (uint64_t frames : frameCounts) {
+        if (!advance(end, frames, (uint64_t) channelCount * sizeof(float))) return 0;
+    }
+    return end <= SIZE_MAX ? end : 0;
+}
+
+void RenderArchive::writeIndex(int sampleRate, int channelCount, const std::vector<uint64_t> &frameCounts) {
+    uint64_t indexOffset = sizeof(t_renderArchiveHeader);
+    uint64_t dataStart = alignUp(indexOffset + frameCounts.size() * sizeof(t_renderArchiveEntry));
+
+    unsigned char *base = (unsigned char *) this->file.getWritableData();
+    t_renderArchiveHeader *h = (t_renderArchiveHeader *) base;
+    h->magic = RENDER_ARCHIVE_MAGIC;
+    h->version = RENDER_ARCHIVE_VERSION;
+    h->sampleRate = (uint32_t) sampleRate;
+    h->channelCount = (uint32_t) channelCount;
+    h->utteranceCount = frameCounts.size();
+    h->indexOffset = indexOffset;
+    h->dataSize = this->file.getSize() - dataStart;
+
+    t_renderArchiveEntry *entries = (t_renderArchiveEntry *) (base + indexOffset);
+    uint64_t offset = dataStart;
+    for (size_t i = 0; i < frameCounts.size(); i++) {
+        entries[i].offset = offset;
+        entries[i].frameCount = frameCounts[i];
+        advance(offset, frameCounts[i], (uint64_t) channelCount * sizeof(float));  // checked by getSize()
+    }
+
+    this->header = h;
+    this->index = entries;
+}
+
+bool RenderArchive::open(const std::string &path) {
+    this->close();
+    return this->file.open(path) && this->validate();
+}
+
+bool RenderArchive::open(int descriptor) {
+    this->close();
+    return this->file.open(descriptor) && this->validate();
+}
+
+bool RenderArchive::validate() {
+    const unsigned char *base = (const unsigned char *) this->file.getData();
+    uint64_t size = this->file.getSize();
+    if (size < sizeof(t_renderArchiveHeader)) {
+        this->close();
+        return false;
+    }
+    const t_renderArchiveHeader *h = (const t_renderArchiveHeader *) base;
+    bool valid = h->magic == RENDER_ARCHIVE_MAGIC
+        && h->version == RENDER_ARCHIVE_VERSION
+        && h->sampleRate > 0
+        && h->channelCount > 0
+        && h->indexOffset % alignof(t_renderArchiveEntry) == 0
+        && h->indexOffset <= size
+        && h->utteranceCount <= (size - h->indexOffset) / sizeof(t_renderArchiveEntry);
+    if (!valid) {
+        this->close();
+        return false;
+    }
+
+    const t_renderArchiveEntry *entries = (const t_renderArchiveEntry *) (base + h->indexOffset);
+    uint64_t frameBytes = (uint64_t) h->channelCount * sizeof(float);
+    for (uint64_t i = 0; i < h->utteranceCount; i++) {
+        if (entries[i].offset % alignof(float) != 0
+            || entries[i].offset > size
+            || entries[i].frameCount > (size - entries[i].offset) / frameBytes) {
+            this->close();
+            return false;
+        }
+    }
+
+    this->header = h;
+    this->index = entries;
+    return true;
+}
+
+void RenderArchive::close() {
+    this->file.close();
+    this->header = nullptr;
+    this->index = nullptr;
+}
+
+uint64_t RenderArchive::getFrameCount(uint64_t utterance) const {
+    if (utterance >= this->getUtteranceCount()) return 0;
+    return this->index[utterance].frameCount;
+}
+
+const float *RenderArchive::getSamples(uint64_t utterance) const {
+    if (utterance >= this->getUtteranceCount()) return nullptr;
+    return (const float *) ((const unsigned char *) this->file.getData() + this->index[utterance].offset);
+}
+
+float *RenderArchive::getWritableSamples(uint64_t utterance) {
+    unsigned char *base = (unsigned char *) this->file.getWritableData();
+    if (!base || utterance >= this->getUtteranceCount()) return nullptr;
+    return (float *) (base + this->index[utterance].offset);
+}
@@ -0,0 +1,89 @@
+//==============================================================================
+// src/core/RenderArchive.h
+// Memory-mapped file of rendered utterances with an index of offsets
+//==============================================================================
+
+#ifndef RenderArchive_h
+#define RenderArchive_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+#define RENDER_ARCHIVE_MAGIC        (0x41525450)    // "PTRA", little-endian
+#define RENDER_ARCHIVE_VERSION      (1)
+#define RENDER_ARCHIVE_ALIGNMENT    (64)            // bytes, per utterance
+// Longest utterance renderers accept, keyframes and tail included
+#define RENDER_MAX_SECONDS          (3600)
+
+// File layout, all little-endian:
+//   t_renderArchiveHeader
+//   t_renderArchiveEntry[utteranceCount]   at header.indexOffset
+//   interleaved float samples              at each entry's offset
+// Every utterance starts on a RENDER_ARCHIVE_ALIGNMENT boundary, so writers
+// filling neighbouring utterances never share a cache line.
+typedef struct t_renderArchiveHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sampleRate;
+    uint32_t channelCount;
+    uint64_t utteranceCount;
+    uint64_t indexOffset;
+    uint64_t dataSize;          // bytes from the end of the index to the end of the file
+} t_renderArchiveHeader;
+
+typedef struct t_renderArchiveEntry {
+    uint64_t offset;            // bytes from the start of the file
+    uint64_t frameCount;
+} t_renderArchiveEntry;
+
+static_assert(sizeof(t_renderArchiveHeader) == 40, "render archive header layout");
+static_assert(sizeof(t_renderArchiveEntry) == 16, "render archive entry layout");
+
+class RenderArchive {
+public:
+    RenderArchive();
+
+    // Creates the file at its final size and writes the header and index, so
+    // utterances can then be filled in any order, from any thread
+    bool create(const std::string &path, int sampleRate, int channelCount,
+                const std::vector<uint64_t> &frameCounts);
+    // Same layout in nameless shared memory, see MappedFile::createShared();
+    // another process maps it from getDescriptor() with open(descriptor)
+    bool createShared(int sampleRate, int channelCount, const std::vector<uint64_t> &frameCounts);
+    // Maps and validates an existing archive read-only
+    bool open(const std::string &path);
+    // Same from a descriptor, which the archive then owns
+    bool open(int descriptor);
+    bool flush() { return this->file.flush(); }
+    void close();
+
+    bool isOpen() const { return header != nullptr; }
+    int getSampleRate() const { return header ? (int) header->sampleRate : 0; }
+    int getChannelCount() const { return header ? (int) header->channelCount : 0; }
+    uint64_t getUtteranceCount() const { return header ? header->utteranceCount : 0; }
+    uint64_t getFrameCount(uint64_t utterance) const;
+    const float *getSamples(uint64_t utterance) const;
+    // Only for archives made with create() or createShared()
+    float *getWritableSamples(uint64_t utterance);
+    size_t getByteSize() const { return file.getSize(); }
+    int getDescriptor() const { return file.getDescriptor(); }
+
+    // Bytes taken by an archive of these utterances, or 0 if that does not
+    // fit in a size_t
+    static uint64_t getSize(int channelCount, const std::vector<uint64_t> &frameCounts);
+
+private:
+    RenderArchive(const RenderArchive &) = delete;
+    RenderArchive &operator=(const RenderArchive &) = delete;
+
+    void writeIndex(int sampleRate, int channelCount, const std::vector<uint64_t> &frameCounts);
+    bool validate();
+
+    MappedFile file;
+    const t_renderArchiveHeader *header;
+    const t_renderArchiveEntry *index;
+};
+
+#endif /* RenderArchive_h */
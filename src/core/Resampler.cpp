@@ -0,0 +1,146 @@
+//==============================================================================
+// src/core/Resampler.cpp
+//==============================================================================
+
+#include "Resampler.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+// Kaiser window shape, about 70 dB of stopband attenuation
+#define KAISER_BETA (7.0)
+// Cutoff as a fraction of the lower of the two rates
+#define CUTOFF      (0.45)
+
+static int greatestCommonDivisor(int a, int b) {
+    while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Modified Bessel function of the first kind, order 0
+static double besselI0(double x) {
+    double sum = 1, term = 1;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+        if (term < sum * 1e-12) break;
+    }
+    return sum;
+}
+
+static inline float dot(const float *a, const float *b, int n) {
+    float acc[4] = { 0, 0, 0, 0 };
+    for (int k = 0; k < n; k += 4) {
+        for (int j = 0; j < 4; j++) acc[j] += a[k + j] * b[k + j];
+    }
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+Resampler::Resampler()
+    : upFactor(1)
+    , downFactor(1)
+    , taps(0)
+    , maxChannels(0)
+    , maxInputFrames(0)
+    , phase(0)
+    , inputIndex(0) {
+}
+
+bool Resampler::setup(int inputRate, int outputRate, int maxChannels, int maxInputFrames, int taps) {
+    this->maxChannels = 0;
+    if (inputRate <= 0 || outputRate <= 0 || maxChannels <= 0 || maxInputFrames <= 0) return false;
+    int divisor = greatestCommonDivisor(inputRate, outputRate);
+    int up = outputRate / divisor;
+    int down = inputRate / divisor;
+    if (up > RESAMPLER_MAX_PHASES) return false;
+
+    this->upFactor = up;
+    this->downFactor = down;
+    // Taps count at the lower rate, so downsampling needs M / L times more
+    if (down > up) taps = (int) ceil(taps * (double) down / up);
+    this->taps = std::max(4, (taps + 3) & ~3);
+    this->maxInputFrames = maxInputFrames;
+
+    // Prototype at the upsampled rate; cutoff in cycles per upsampled sample
+    int length = this->taps * up;
+    double cutoff = CUTOFF / std::max(up, down);
+    double center = (length - 1) / 2.0;
+    std::vector<double> prototype(length);
+    for (int n = 0; n < length; n++) {
+        double x = n - center;
+        double sinc = x == 0 ? 2 * cutoff : sin(2 * M_PI * cutoff * x) / (M_PI * x);
+        double r = x / (center + 1);
+        prototype[n] = sinc * besselI0(KAISER_BETA * sqrt(std::max(0.0, 1 - r * r))) / besselI0(KAISER_BETA);
+    }
+
+    // Phase p weighs input frame i - k with prototype[p + k * L]; store each
+    // phase oldest frame first so it lines up with the history
+    this->coefficients.assign((size_t) up * this->taps, 0);
+    for (int p = 0; p < up; p++) {
+        float *c = &this->coefficients[(size_t) p * this->taps];
+        double sum = 0;
+        for (int k = 0; k < this->taps; k++) sum += prototype[p + k * up];
+        for (int k = 0; k < this->taps; k++) {
+            c[this->taps - 1 - k] = (float) (prototype[p + k * up] / sum);
+        }
+    }
+
+    this->history.assign((size_t) maxChannels * (this->taps + maxInputFrames), 0);
+    this->maxChannels = maxChannels;
+    this->reset();
+    return true;
+}
+
+void Resampler::reset() {
+    std::fill(this->history.begin(), this->history.end(), 0.0f);
+    this->phase = 0;
+    this->inputIndex = 0;
+}
+
+int Resampler::getInputFrames(int outputFrames) const {
+    if (outputFrames <= 0) return 0;
+    long long last = (long long) this->phase + (long long) (outputFrames - 1) * this->downFactor;
+    return std::max(0, this->inputIndex + (int) (last / this->upFactor) + 1);
+}
+
+int Resampler::process(const float *input, int inputFrames, int numChannels,
+                       float *output, int maxOutputFrames, bool accumulate) {
+    if (!this->isSetup() || numChannels <= 0 || numChannels > this->maxChannels) return 0;
+    inputFrames = std::min(inputFrames, this->maxInputFrames);
+    int keep = this->taps;
+    int stride = keep + this->maxInputFrames;
+
+    // Deinterleave the block after each channel's history
+    for (int ch = 0; ch < numChannels; ch++) {
+        float *h = &this->history[(size_t) ch * stride] + keep;
+        for (int i = 0; i < inputFrames; i++) h[i] = input[i * numChannels + ch];
+    }
+
+    int produced = 0;
+    while (this->inputIndex < inputFrames && produced < maxOutputFrames) {
+        const float *c = &this->coefficients[(size_t) this->phase * this->taps];
+        float *frame = output + produced * numChannels;
+        for (int ch = 0; ch < numChannels; ch++) {
+            // Window ending at inputIndex: history index keep + inputIndex - (taps - 1)
+            const float *x = &this->history[(size_t) ch * stride] + this->inputIndex + 1;
+            float y = dot(c, x, this->taps);
+            frame[ch] = accumulate ? frame[ch] + y : y;
+        }
+        produced++;
+        this->phase += this->downFactor;
+        this->inputIndex += this->phase / this->upFactor;
+        this->phase %= this->upFactor;
+    }
+    this->inputIndex -= inputFrames;
+
+    // Keep the last taps frames for the next block
+    for (int ch = 0; ch < numChannels; ch++) {
+        float *h = &this->history[(size_t) ch * stride];
+        memmove(h, h + inputFrames, keep * sizeof(float));
+    }
+    return produced;
+}
@@ -0,0 +1,64 @@
+//==============================================================================
+// src/core/Resampler.h
+// Polyphase sample rate converter for interleaved float streams
+//==============================================================================
+
+#ifndef Resampler_h
+#define Resampler_h
+
+#include <vector>
+
+#define RESAMPLER_DEFAULT_TAPS  (32)     // per phase at the lower rate, rounded up to a multiple of 4
+#define RESAMPLER_MAX_PHASES    (1024)
+
+// Rational L/M converter: the ratio of the integer rates is reduced, and a
+// Kaiser-windowed sinc prototype of taps * L coefficients is split into L
+// phases, each normalized to unity DC gain. Every output frame is one dot
+// product of a phase against the last taps input frames, computed with four
+// independent accumulators so compilers map it onto SIMD lanes. The cutoff
+// sits at 0.45 of the lower rate; with 32 taps the response is flat to about
+// 0.38 and images are down about 70 dB past 0.52 of that rate.
+//
+// The converter is pulled from the output side: getInputFrames() says how
+// many input frames make exactly the next outputFrames, so a caller renders
+// just that much at the input rate. Latency is half the filter length.
+class Resampler {
+public:
+    Resampler();
+
+    // Allocates; returns false for rates whose reduced ratio needs more than
+    // RESAMPLER_MAX_PHASES phases. maxInputFrames and maxChannels bound each
+    // process() call.
+    bool setup(int inputRate, int outputRate, int maxChannels, int maxInputFrames,
+               int taps = RESAMPLER_DEFAULT_TAPS);
+    // Clears the history, as if the input had been silent
+    void reset();
+
+    bool isSetup() const { return maxChannels > 0; }
+    int getLatency() const { return taps / 2; }     // input frames
+
+    // Input frames to pass to the next process() call for it to produce
+    // exactly outputFrames
+    int getInputFrames(int outputFrames) const;
+
+    // Consumes inputFrames (at most maxInputFrames) interleaved frames of
+    // numChannels (at most maxChannels) and writes the output frames they
+    // complete, up to maxOutputFrames; returns the count. Each channel keeps
+    // its own history, so the channel count should stay the same from call to
+    // call. Never allocates.
+    int process(const float* input, int inputFrames, int numChannels,
+                float* output, int maxOutputFrames, bool accumulate = false);
+
+private:
+    int upFactor, downFactor;       // L, M
+    int taps;
+    int maxChannels;
+    int maxInputFrames;
+    std::vector<float> coefficients;    // L phases of taps, in input order
+    std::vector<float> history;         // per channel: taps past frames, then the block
+    int phase;                          // of the next output, 0 .. L - 1
+    int inputIndex;                     // newest input frame it needs, relative to the
+                                        // next block; -1 when that is the last one seen
+};
+
+#endif /* Resampler_h */
@@ -0,0 +1,178 @@
+//==============================================================================
+// src/core/ScopeBuffer.cpp
+//==============================================================================
+
+#include "ScopeBuffer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#define RAW_MASK ((uint64_t) SCOPE_RAW_SAMPLES - 1)
+
+static const float emptyMin = std::numeric_limits<float>::infinity();
+static const float emptyMax = -std::numeric_limits<float>::infinity();
+
+ScopeBuffer::ScopeBuffer(float sampleRate, double historySeconds, int numLevels)
+    : sampleRate(sampleRate)
+    , historySeconds(historySeconds)
+    , numLevels(std::min(std::max(numLevels, 1), SCOPE_MAX_LEVELS))
+    , written(0)
+    , writing(0) {
+    uint64_t size = SCOPE_BASE_BUCKET;
+    for (int i = 0; i < this->numLevels; i++) {
+        Level &level = this->levels[i];
+        // Room for the history, plus slack so readers rarely lose buckets
+        uint64_t needed = (uint64_t) std::ceil(historySeconds * sampleRate / size);
+        needed += needed / 4 + 64;
+        uint64_t capacity = 1;
+        while (capacity < needed) capacity <<= 1;
+        level.buckets.reset(new Bucket[capacity]);
+        for (uint64_t j = 0; j < capacity; j++) {
+            level.buckets[j].min.store(emptyMin, std::memory_order_relaxed);
+            level.buckets[j].max.store(emptyMax, std::memory_order_relaxed);
+        }
+        level.mask = capacity - 1;
+        level.size = size;
+        level.min = emptyMin;
+        level.max = emptyMax;
+        level.fill = 0;
+        this->bucketCounts[i] = 0;
+        size *= SCOPE_LEVEL_FACTOR;
+    }
+    this->raw.reset(new std::atomic<float>[SCOPE_RAW_SAMPLES]);
+    for (int i = 0; i < SCOPE_RAW_SAMPLES; i++) this->raw[i].store(0.0f, std::memory_order_relaxed);
+}
+
+void ScopeBuffer::write(const float *samples, int numFrames, int numChannels, int channel) {
+    uint64_t start = this->written.load(std::memory_order_relaxed);
+    this->writing.store(start + numFrames, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Level &first = this->levels[0];
+    const float *p = samples + channel;
+    for (int i = 0; i < numFrames; i++, p += numChannels) {
+        float x = *p;
+        this->raw[(start + i) & RAW_MASK].store(x, std::memory_order_relaxed);
+        if (x < first.min) first.min = x;
+        if (x > first.max) first.max = x;
+        if (++first.fill == (int) first.size) {
+            this->publish(0, first.min, first.max);
+            first.min = emptyMin;
+            first.max = emptyMax;
+            first.fill = 0;
+        }
+    }
+    this->written.store(start + numFrames, std::memory_order_release);
+}
+
+void ScopeBuffer::publish(int level, float min, float max) {
+    Level &l = this->levels[level];
+    Bucket &bucket = l.buckets[this->bucketCounts[level]++ & l.mask];
+    bucket.min.store(min, std::memory_order_relaxed);
+    bucket.max.store(max, std::memory_order_relaxed);
+    if (level + 1 >= this->numLevels) return;
+
+    Level &next = this->levels[level + 1];
+    next.min = std::min(next.min, min);
+    next.max = std::max(next.max, max);
+    if (++next.fill == SCOPE_LEVEL_FACTOR) {
+        this->publish(level + 1, next.min, next.max);
+        next.min = emptyMin;
+        next.max = emptyMax;
+        next.fill = 0;
+    }
+}
+
+double ScopeBuffer::read(t_scopeColumn *columns, int numColumns, double seconds) const {
+    if (numColumns <= 0) return 0;
+    uint64_t end = this->written.load(std::memory_order_acquire);
+    double perColumn = std::max(seconds, 0.0) * this->sampleRate / numColumns;
+
+    // Coarsest level with at least one bucket per column
+    int level = -1;
+    for (int i = 0; i < this->numLevels && this->levels[i].size <= perColumn; i++) level = i;
+    bool useRaw = level < 0 && perColumn * numColumns <= SCOPE_RAW_SAMPLES;
+    if (!useRaw) level = std::max(level, 0);
+
+    if (useRaw) this->readRaw(columns, numColumns, end, perColumn, 0);
+    else this->readLevel(this->levels[level], columns, numColumns, end, perColumn, 0);
+
+    // Drop what the writer may have overwritten meanwhile
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t limit = this->writing.load(std::memory_order_relaxed);
+    if (useRaw) this->readRaw(columns, numColumns, end, perColumn, limit);
+    else this->readLevel(this->levels[level], columns, numColumns, end, perColumn, limit);
+    return perColumn;
+}
+
+// With limit 0, fills the columns; otherwise empties those holding samples a
+// write reaching limit may have overwritten. Samples [first, last) go to
+// column c, starting at the ceiling of its left edge so none is counted twice.
+void ScopeBuffer::readRaw(t_scopeColumn *columns, int numColumns, uint64_t end, double perColumn,
+                          uint64_t limit) const {
+    double windowStart = (double) end - perColumn * numColumns;
+    double oldest = limit > SCOPE_RAW_SAMPLES ? (double) (limit - SCOPE_RAW_SAMPLES) : 0.0;
+    for (int c = 0; c < numColumns; c++) {
+        double left = windowStart + c * perColumn;
+        double first = std::ceil(left);
+        double last = std::ceil(left + perColumn);
+        if (last <= first) {
+            // Column narrower than a sample: the sample it falls in
+            first = std::floor(left);
+            last = first + 1;
+        }
+        first = std::max(first, 0.0);
+        last = std::max(std::min(last, (double) end), first);
+        if (limit > 0) {
+            if (first < oldest) {
+                columns[c].min = emptyMin;
+                columns[c].max = emptyMax;
+            }
+            continue;
+        }
+        float min = emptyMin, max = emptyMax;
+        for (uint64_t s = (uint64_t) first; s < (uint64_t) last; s++) {
+            float x = this->raw[s & RAW_MASK].load(std::memory_order_relaxed);
+            min = std::min(min, x);
+            max = std::max(max, x);
+        }
+        columns[c].min = min;
+        columns[c].max = max;
+    }
+}
+
+// Same per bucket, over the buckets complete at end
+void ScopeBuffer::readLevel(const Level &level, t_scopeColumn *columns, int numColumns, uint64_t end,
+                            double perColumn, uint64_t limit) const {
+    double size = (double) level.size;
+    double complete = (double) (end / level.size);
+    double windowStart = complete * size - perColumn * numColumns;
+    double capacity = (double) (level.mask + 1);
+    double oldest = std::max(0.0, (double) (limit / level.size) - capacity);
+    for (int c = 0; c < numColumns; c++) {
+        double left = windowStart + c * perColumn;
+        double first = std::ceil(left / size);
+        double last = std::ceil((left + perColumn) / size);
+        if (last <= first) {
+            first = std::floor(left / size);
+            last = first + 1;
+        }
+        first = std::max(first, 0.0);
+        last = std::max(std::min(last, complete), first);
+        if (limit > 0) {
+            if (first < oldest) {
+                columns[c].min = emptyMin;
+                columns[c].max = emptyMax;
+            }
+            continue;
+        }
+        float min = emptyMin, max = emptyMax;
+        for (uint64_t j = (uint64_t) first; j < (uint64_t) last; j++) {
+            const Bucket &bucket = level.buckets[j & level.mask];
+            min = std::min(min, bucket.min.load(std::memory_order_relaxed));
+            max = std::max(max, bucket.max.load(std::memory_order_relaxed));
+        }
+        columns[c].min = min;
+        columns[c].max = max;
+    }
+}
@@ -0,0 +1,84 @@
+//==============================================================================
+// src/core/ScopeBuffer.h
+// Lock-free oscilloscope tap: a ring of recent samples plus min/max
+// summaries at several zoom levels, written by the audio thread
+//==============================================================================
+
+#ifndef ScopeBuffer_h
+#define ScopeBuffer_h
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+#define SCOPE_MAX_LEVELS    (8)
+#define SCOPE_BASE_BUCKET   (16)        // samples per bucket at level 0
+#define SCOPE_LEVEL_FACTOR  (4)         // buckets folded into one at the next level
+#define SCOPE_RAW_SAMPLES   (65536)     // recent samples kept for close zoom
+
+// Range of the signal over one screen column. Columns with no data yet, or
+// whose data the writer overwrote while they were read, have min > max.
+typedef struct t_scopeColumn {
+    float min, max;
+} t_scopeColumn;
+
+// The audio thread appends samples with write(); it never waits, allocates or
+// copies beyond the summaries. Level L keeps the min and max of every
+// SCOPE_BASE_BUCKET * SCOPE_LEVEL_FACTOR^L samples for the whole history, so
+// read() fills each column from the coarsest level that still has a bucket
+// per column, folding at most a few buckets per column: drawing seconds of
+// history costs O(width) whatever the zoom. Windows narrower than one bucket
+// per column come from the raw samples.
+//
+// Any number of threads may read while the audio thread writes. Before it
+// touches the rings the writer publishes how far it is about to write, and a
+// reader discards any bucket that write may have reached.
+class ScopeBuffer {
+public:
+    ScopeBuffer(float sampleRate, double historySeconds = 10.0, int numLevels = 5);
+
+    // Audio thread: one channel of an interleaved buffer
+    void write(const float *samples, int numFrames, int numChannels = 1, int channel = 0);
+
+    // Any thread: the last seconds of output as numColumns columns, oldest
+    // first. Returns the samples covered by each column.
+    double read(t_scopeColumn *columns, int numColumns, double seconds) const;
+
+    float getSampleRate() const { return sampleRate; }
+    double getHistorySeconds() const { return historySeconds; }
+    uint64_t getSampleCount() const { return written.load(std::memory_order_acquire); }
+
+private:
+    ScopeBuffer(const ScopeBuffer &) = delete;
+    ScopeBuffer &operator=(const ScopeBuffer &) = delete;
+
+    struct Bucket {
+        std::atomic<float> min, max;
+    };
+    struct Level {
+        std::unique_ptr<Bucket[]> buckets;
+        uint64_t mask;
+        uint64_t size;              // samples per bucket
+        // Writer only: the bucket being filled
+        float min, max;
+        int fill;                   // samples, or lower-level buckets above level 0
+    };
+
+    void publish(int level, float min, float max);
+    void readRaw(t_scopeColumn *columns, int numColumns, uint64_t end, double perColumn,
+                 uint64_t limit) const;
+    void readLevel(const Level &level, t_scopeColumn *columns, int numColumns, uint64_t end,
+                   double perColumn, uint64_t limit) const;
+
+    float sampleRate;
+    double historySeconds;
+    int numLevels;
+    Level levels[SCOPE_MAX_LEVELS];
+    uint64_t bucketCounts[SCOPE_MAX_LEVELS];    // writer only: published per level
+    std::unique_ptr<std::atomic<float>[]> raw;
+
+    std::atomic<uint64_t> written;  // samples complete
+    std::atomic<uint64_t> writing;  // samples the current write() reaches
+};
+
+#endif /* ScopeBuffer_h */
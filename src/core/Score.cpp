@@ -0,0 +1,129 @@
+//==============================================================================
+// src/core/Score.cpp
+//==============================================================================
+
+#include "Score.h"
+#include <algorithm>
+#include <fstream>
+
+Score::Score()
+    : header(nullptr)
+    , voices(nullptr)
+    , keyframes(nullptr) {
+}
+
+bool Score::load(const std::string &path) {
+    this->close();
+    if (!this->file.open(path)) return false;
+    return this->attach((const unsigned char *) this->file.getData(), this->file.getSize());
+}
+
+bool Score::load(const void *data, size_t size) {
+    this->close();
+    if (!data || (uintptr_t) data % alignof(t_scoreKeyframe) != 0) return false;
+    return this->attach((const unsigned char *) data, size);
+}
+
+bool Score::attach(const unsigned char *base, size_t size) {
+    if (size < sizeof(t_scoreHeader)) {
+        this->close();
+        return false;
+    }
+    const t_scoreHeader *h = (const t_scoreHeader *) base;
+    uint64_t voiceBytes = (uint64_t) h->voiceCount * sizeof(t_scoreVoice);
+    uint64_t keyframeBytes;
+    bool valid = !__builtin_mul_overflow(h->keyframeCount, (uint64_t) sizeof(t_scoreKeyframe), &keyframeBytes)
+        && h->magic == SCORE_MAGIC
+        && h->version == SCORE_VERSION
+        && h->sampleRate > 0
+        && h->voiceTableOffset % alignof(t_scoreVoice) == 0
+        && h->keyframeOffset % alignof(t_scoreKeyframe) == 0
+        && h->voiceTableOffset <= size && voiceBytes <= size - h->voiceTableOffset
+        && h->keyframeOffset <= size && keyframeBytes <= size - h->keyframeOffset;
+    if (!valid) {
+        this->close();
+        return false;
+    }
+
+    // Each voice's keyframes must lie in the array and be in time order, which
+    // ScoreSequencer relies on to seek and advance
+    const t_scoreVoice *v = (const t_scoreVoice *) (base + h->voiceTableOffset);
+    const t_scoreKeyframe *k = (const t_scoreKeyframe *) (base + h->keyframeOffset);
+    for (uint32_t i = 0; i < h->voiceCount; i++) {
+        if (v[i].firstKeyframe > h->keyframeCount
+            || v[i].keyframeCount > h->keyframeCount - v[i].firstKeyframe) {
+            this->close();
+            return false;
+        }
+        const t_scoreKeyframe *first = k + v[i].firstKeyframe;
+        for (uint64_t j = 1; j < v[i].keyframeCount; j++) {
+            if (first[j].sampleTime < first[j - 1].sampleTime) {
+                this->close();
+                return false;
+            }
+        }
+    }
+
+    this->header = h;
+    this->voices = v;
+    this->keyframes = k;
+    return true;
+}
+
+void Score::close() {
+    this->file.close();
+    this->header = nullptr;
+    this->voices = nullptr;
+    this->keyframes = nullptr;
+}
+
+uint64_t Score::getKeyframeCount(int voice) const {
+    if (voice < 0 || voice >= this->getVoiceCount()) return 0;
+    return this->voices[voice].keyframeCount;
+}
+
+const t_scoreKeyframe *Score::getKeyframes(int voice) const {
+    if (voice < 0 || voice >= this->getVoiceCount()) return nullptr;
+    return this->keyframes + this->voices[voice].firstKeyframe;
+}
+
+uint64_t Score::getLength() const {
+    uint64_t length = 0;
+    for (int i = 0; i < this->getVoiceCount(); i++) {
+        uint64_t count = this->voices[i].keyframeCount;
+        if (count > 0) length = std::max(length, this->getKeyframes(i)[count - 1].sampleTime);
+    }
+    return length;
+}
+
+bool Score::write(const std::string &path, int sampleRate,
+                  const std::vector<std::vector<t_scoreKeyframe>> &voices) {
+    t_scoreHeader h;
+    h.magic = SCORE_MAGIC;
+    h.version = SCORE_VERSION;
+    h.sampleRate = (uint32_t) sampleRate;
+    h.voiceCount = (uint32_t) voices.size();
+    h.keyframeCount = 0;
+    for (const auto &v : voices) h.keyframeCount += v.size();
+    h.voiceTableOffset = sizeof(t_scoreHeader);
+    h.keyframeOffset = h.voiceTableOffset + voices.size() * sizeof(t_scoreVoice);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write((const char *) &h, sizeof(h));
+
+    uint64_t first = 0;
+    for (const auto &v : voices) {
+        t_scoreVoice entry = { first, (uint64_t) v.size() };
+        out.write((const char *) &entry, sizeof(entry));
+        first += v.size();
+    }
+
+    for (const auto &v : voices) {
+        std::vector<t_scoreKeyframe> sorted(v);
+        std::stable_sort(sorted.begin(), sorted.end(),
+                         [](const t_scoreKeyframe &a, const t_scoreKeyframe &b) { return a.sampleTime < b.sampleTime; });
+        if (!sorted.empty()) out.write((const char *) sorted.data(), sorted.size() * sizeof(t_scoreKeyframe));
+    }
+    return (bool) out;
+}
@@ -0,0 +1,94 @@
+//==============================================================================
+// src/core/Score.h
+// Binary articulation score: fixed-size keyframes, grouped by voice and
+// sorted by sample time, read in place from a memory-mapped file
+//==============================================================================
+
+#ifndef Score_h
+#define Score_h
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+
+#define SCORE_MAGIC     (0x43535450)    // "PTSC", little-endian
+#define SCORE_VERSION   (1)
+
+// File layout, all little-endian and naturally aligned:
+//   t_scoreHeader
+//   t_scoreVoice[voiceCount]          at header.voiceTableOffset
+//   t_scoreKeyframe[keyframeCount]    at header.keyframeOffset
+typedef struct t_scoreHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sampleRate;
+    uint32_t voiceCount;
+    uint64_t keyframeCount;
+    uint64_t voiceTableOffset;
+    uint64_t keyframeOffset;
+} t_scoreHeader;
+
+typedef struct t_scoreVoice {
+    uint64_t firstKeyframe;     // index into the keyframe array
+    uint64_t keyframeCount;
+} t_scoreVoice;
+
+// Which parameter groups a keyframe sets; the others are left alone
+typedef enum t_scoreFlags {
+    SCORE_FREQUENCY     = 1 << 0,
+    SCORE_TENSENESS     = 1 << 1,
+    SCORE_TONGUE        = 1 << 2,   // tongueIndex, tongueDiameter
+    SCORE_CONSTRICTION  = 1 << 3    // constrictionIndex, constrictionDiameter, fricative
+} t_scoreFlags;
+
+typedef struct t_scoreKeyframe {
+    uint64_t sampleTime;
+    float frequency;
+    float tenseness;
+    float tongueIndex;
+    float tongueDiameter;
+    float constrictionIndex;
+    float constrictionDiameter;
+    float fricative;
+    uint32_t flags;
+} t_scoreKeyframe;
+
+static_assert(sizeof(t_scoreHeader) == 40, "score header layout");
+static_assert(sizeof(t_scoreVoice) == 16, "score voice layout");
+static_assert(sizeof(t_scoreKeyframe) == 40, "score keyframe layout");
+
+class Score {
+public:
+    Score();
+
+    // Maps and validates a score file; keyframes are then used in place.
+    // Fails unless every table lies inside the data and each voice's
+    // keyframes are in time order, so untrusted scores can be loaded.
+    bool load(const std::string &path);
+    // Validates a score image in memory, which must outlive the Score
+    bool load(const void *data, size_t size);
+    void close();
+
+    bool isLoaded() const { return header != nullptr; }
+    int getSampleRate() const { return header ? (int) header->sampleRate : 0; }
+    int getVoiceCount() const { return header ? (int) header->voiceCount : 0; }
+    uint64_t getKeyframeCount(int voice) const;
+    const t_scoreKeyframe *getKeyframes(int voice) const;
+    // Sample time of the last keyframe of any voice
+    uint64_t getLength() const;
+
+    // Writes a score file; each voice's keyframes are sorted by sample time
+    static bool write(const std::string &path, int sampleRate,
+                      const std::vector<std::vector<t_scoreKeyframe>> &voices);
+
+private:
+    bool attach(const unsigned char *base, size_t size);
+
+    MappedFile file;
+    const t_scoreHeader *header;
+    const t_scoreVoice *voices;
+    const t_scoreKeyframe *keyframes;
+};
+
+#endif /* Score_h */
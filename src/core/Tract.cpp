@@ -5,18 +5,12 @@
 
 #include "Tract.h"
 #include <math.h>
+#include <cmath>
 #include "util.h"
+#include "DiagnosticLog.h"
+#include "Profiler.h"
 
-typedef struct t_transient {
-    int position;
-    sample_t timeAlive;
-    sample_t lifeTime;
-    sample_t strength;
-    sample_t exponent;
-    bool living;
-} t_transient;
-
-void initializeTractProps(t_tractProps *props, int n)
+void initializeTractProps(t_tractProps *props, int n, sample_t *tractDiameter, sample_t *noseDiameter)
 {
     props->n = n;
     props->bladeStart = BLADE_START;
@@ -28,125 +22,197 @@ void initializeTractProps(t_tractProps *props, int n)
     props->lipStart = (int) floor(props->lipStart * (sample_t) n / NUM_CONSTRICTIONS);
     props->tongueIndex = props->bladeStart;
     props->tongueDiameter = TONGUE_DIAMETER;
-    props->tractDiameter = (sample_t *) calloc(n, sizeof(sample_t));
+    props->tractDiameter = tractDiameter ? tractDiameter : (sample_t *) calloc(n, sizeof(sample_t));
     props->noseLength = (int) floor(props->noseLength * (sample_t) props->n / NUM_CONSTRICTIONS);
-    props->noseDiameter = (sample_t *) calloc(props->noseLength, sizeof(sample_t));
+    props->noseDiameter = noseDiameter ? noseDiameter : (sample_t *) calloc(props->noseLength, sizeof(sample_t));
     props->noseStart = props->n - props->noseLength + 1;
     props->noseOffset = NOSE_OFFSET;
+    props->shapeVersion = 0;
+}
+
+//==============================================================================
+// Tract
+//==============================================================================
+
+Tract *Tract::create(sample_t sampleRate, sample_t blockTime, t_tractProps *props, t_tractPrecision precision)
+{
+    bool useDouble = precision == TRACT_PRECISION_DOUBLE;
+    switch (props->n) {
+        case 22:
+            if (useDouble) return new Tract22d(sampleRate, blockTime, props);
+            return new Tract22f(sampleRate, blockTime, props);
+        case 44:
+            if (useDouble) return new Tract44d(sampleRate, blockTime, props);
+            return new Tract44f(sampleRate, blockTime, props);
+        default:
+            return nullptr;
+    }
 }
 
-Tract::Tract(sample_t sampleRate, sample_t blockTime, t_tractProps *props):
+Tract *Tract::create(void *memory, sample_t sampleRate, sample_t blockTime, t_tractProps *props, t_tractPrecision precision)
+{
+    bool useDouble = precision == TRACT_PRECISION_DOUBLE;
+    switch (props->n) {
+        case 22:
+            if (useDouble) return new (memory) Tract22d(sampleRate, blockTime, props);
+            return new (memory) Tract22f(sampleRate, blockTime, props);
+        case 44:
+            if (useDouble) return new (memory) Tract44d(sampleRate, blockTime, props);
+            return new (memory) Tract44f(sampleRate, blockTime, props);
+        default:
+            return nullptr;
+    }
+}
+
+size_t Tract::getSize(int n, t_tractPrecision precision)
+{
+    bool useDouble = precision == TRACT_PRECISION_DOUBLE;
+    switch (n) {
+        case 22: return useDouble ? sizeof(Tract22d) : sizeof(Tract22f);
+        case 44: return useDouble ? sizeof(Tract44d) : sizeof(Tract44f);
+        default: return 0;
+    }
+}
+
+Tract::Tract(t_tractProps *props):
     lipOutput(0),
     noseOutput(0),
-    glottalReflection(GLOTTAL_REFLECTION),
-    lipReflection(LIP_REFLECTION),
-    lastObstruction(-1),
-    fade(TRACT_FADE), //0.9999,
-    movementSpeed(MOVEMENT_SPEED), //cm per second
-    velumTarget(0.01),
-    constrictionIndex(3.0), // TODO values ex recto
-    constrictionDiameter(1.0) // TODO values ex recto
+    tractProps(props)
+{
+}
+
+long Tract::getTractIndexCount()
+{
+    return this->tractProps->n;
+}
+
+long Tract::tongueIndexLowerBound()
+{
+    return this->tractProps->bladeStart + 2;
+}
+
+long Tract::tongueIndexUpperBound()
+{
+    return this->tractProps->tipStart - 3;
+}
+
+//==============================================================================
+// BasicTract
+//==============================================================================
+
+template <int N, int NoseN, typename Sample>
+BasicTract<N, NoseN, Sample>::BasicTract(sample_t sampleRate, sample_t blockTime, t_tractProps *props):
+    Tract(props),
+    State()
 {
     this->sampleRate = sampleRate;
     this->blockTime = blockTime;
-    this->transients = (t_transient *) calloc(MAX_TRANSIENTS, sizeof(t_transient));
+    this->glottalReflection = GLOTTAL_REFLECTION;
+    this->lipReflection = LIP_REFLECTION;
+    this->lastObstruction = -1;
+    this->fade = TRACT_FADE; //0.9999
+    this->movementSpeed = MOVEMENT_SPEED; //cm per second
+    this->velumTarget = 0.01;
+    this->restVelum = 0.01;
+    this->noseBypassed = false;
     this->transientCount = 0;
-    this->tractProps = props;
+    randomSeed(&this->random, 0);
+    for (int i = 0; i < MAX_CONSTRICTIONS; i++) this->clearConstriction(i);
     this->init();
 }
 
-Tract::~Tract() {
-    if (diameter) free(diameter);
-    if (restDiameter) free(restDiameter);
-    if (targetDiameter) free(targetDiameter);
-    if (newDiameter) free(newDiameter);
-    if (R) free(R);
-    if (L) free(L);
-    if (reflection) free(reflection);
-    if (newReflection) free(newReflection);
-    if (junctionOutputR) free(junctionOutputR);
-    if (junctionOutputL) free(junctionOutputL);
-    if (A) free(A);
-    if (maxAmplitude) free(maxAmplitude);
-    if (noseR) free(noseR);
-    if (noseL) free(noseL);
-    if (noseJunctionOutputR) free(noseJunctionOutputR);
-    if (noseJunctionOutputL) free(noseJunctionOutputL);
-    if (noseReflection) free(noseReflection);
-    if (noseDiameter) free(noseDiameter);
-    if (noseA) free(noseA);
-    if (noseMaxAmplitude) free(noseMaxAmplitude);
-    if (transients) free(transients);
-}
-
-void Tract::init() {
-    this->diameter = (sample_t *) calloc(this->tractProps->n, sizeof(sample_t));
-    this->restDiameter = (sample_t *) calloc(this->tractProps->n, sizeof(sample_t));
-    this->targetDiameter = (sample_t *) calloc(this->tractProps->n, sizeof(sample_t));
-    this->newDiameter = (sample_t *) calloc(this->tractProps->n, sizeof(sample_t));
-    for (int i = 0; i < this->tractProps->n; i++)
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::init() {
+    for (int i = 0; i < N; i++)
     {
-        sample_t diameter = 0;
-        if (i < TRACT_BOUND_A * (sample_t) this->tractProps->n - 0.5) diameter = TRACT_DIAMETER_A;
-        else if (i < TRACT_BOUND_B * (sample_t) this->tractProps->n) diameter = TRACT_DIAMETER_B;
+        Sample diameter = 0;
+        if (i < TRACT_BOUND_A * (Sample) N - 0.5) diameter = TRACT_DIAMETER_A;
+        else if (i < TRACT_BOUND_B * (Sample) N) diameter = TRACT_DIAMETER_B;
         else diameter = TRACT_DIAMETER_C;
         this->diameter[i] = this->restDiameter[i] = this->targetDiameter[i] = this->newDiameter[i] = diameter;
     }
-    this->R = (sample_t *) calloc(this->tractProps->n, sizeof(sample_t));
-    this->L = (sample_t *) calloc(this->tractProps->n, sizeof(sample_t));
-    this->reflection = (sample_t *) calloc(this->tractProps->n + 1, sizeof(sample_t));
-    this->newReflection = (sample_t *) calloc(this->tractProps->n + 1, sizeof(sample_t));
-    this->junctionOutputR = (sample_t *) calloc(this->tractProps->n + 1, sizeof(sample_t));
-    this->junctionOutputL = (sample_t *) calloc(this->tractProps->n + 1, sizeof(sample_t));
-    this->A = (sample_t *) calloc(this->tractProps->n, sizeof(sample_t));
-    this->maxAmplitude = (sample_t *) calloc(this->tractProps->n, sizeof(sample_t));
-    
-    this->noseR = (sample_t *) calloc(this->tractProps->noseLength, sizeof(sample_t));
-    this->noseL = (sample_t *) calloc(this->tractProps->noseLength, sizeof(sample_t));
-    this->noseJunctionOutputR = (sample_t *) calloc(this->tractProps->noseLength + 1, sizeof(sample_t));
-    this->noseJunctionOutputL = (sample_t *) calloc(this->tractProps->noseLength + 1, sizeof(sample_t));
-    this->noseReflection = (sample_t *) calloc(this->tractProps->noseLength + 1, sizeof(sample_t));
-    this->noseDiameter = (sample_t *) calloc(this->tractProps->noseLength, sizeof(sample_t));
-    this->noseA = (sample_t *) calloc(this->tractProps->noseLength, sizeof(sample_t));
-    this->noseMaxAmplitude = (sample_t *) calloc(this->tractProps->noseLength, sizeof(sample_t));
-    for (int i = 0; i < this->tractProps->noseLength; i++)
+    this->R.fill(0);
+    this->L.fill(0);
+    this->reflection.fill(0);
+    this->newReflection.fill(0);
+    this->junctionOutputR.fill(0);
+    this->junctionOutputL.fill(0);
+    this->A.fill(0);
+    this->maxAmplitude.fill(0);
+
+    this->noseR.fill(0);
+    this->noseL.fill(0);
+    this->noseJunctionOutputR.fill(0);
+    this->noseJunctionOutputL.fill(0);
+    this->noseReflection.fill(0);
+    this->noseA.fill(0);
+    this->noseMaxAmplitude.fill(0);
+    for (int i = 0; i < NoseN; i++)
     {
-        sample_t diameter;
-        sample_t d = 2.0 * ((sample_t) i / (sample_t) this->tractProps->noseLength);
+        Sample diameter;
+        Sample d = 2.0 * ((Sample) i / (Sample) NoseN);
         if (d < 1.0) diameter = 0.4 + 1.6 * d;
         else diameter = 0.5 + 1.5 * (2.0 - d);
         diameter = fmin(diameter, 1.9);
         this->noseDiameter[i] = diameter;
     }
+    this->reflectionLeft = this->reflectionRight = this->reflectionNose = 0.0;
     this->newReflectionLeft = this->newReflectionRight = this->newReflectionNose = 0.0;
     this->calculateReflections();
     this->calculateNoseReflections();
     this->noseDiameter[0] = this->velumTarget;
-    memcpy(this->tractProps->tractDiameter, this->diameter, sizeof(sample_t) * this->tractProps->n);
-    memcpy(this->tractProps->noseDiameter, this->noseDiameter, sizeof(sample_t) * this->tractProps->noseLength);
+    this->copyDiameters();
 }
 
-long Tract::getTractIndexCount()
+template <int N, int NoseN, typename Sample>
+t_tractPrecision BasicTract<N, NoseN, Sample>::getPrecision()
 {
-    return this->tractProps->n;
+    return sizeof(Sample) == sizeof(double) ? TRACT_PRECISION_DOUBLE : TRACT_PRECISION_FLOAT;
 }
 
-long Tract::tongueIndexLowerBound()
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::saveState(void *state)
 {
-    return this->tractProps->bladeStart + 2;
+    this->savedLipOutput = this->lipOutput;
+    this->savedNoseOutput = this->noseOutput;
+    memcpy(state, static_cast<State *>(this), sizeof(State));
 }
 
-long Tract::tongueIndexUpperBound()
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::restoreState(const void *state)
 {
-    return this->tractProps->tipStart - 3;
+    memcpy(static_cast<State *>(this), state, sizeof(State));
+    this->lipOutput = this->savedLipOutput;
+    this->noseOutput = this->savedNoseOutput;
+    this->copyDiameters();
 }
 
-void Tract::addTransient(int position)
+// Publish the current shape to the visualization arrays in tractProps,
+// marking it dirty when anything changed
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::copyDiameters()
+{
+    bool changed = false;
+    for (int i = 0; i < N; i++) {
+        sample_t d = (sample_t) this->diameter[i];
+        changed |= this->tractProps->tractDiameter[i] != d;
+        this->tractProps->tractDiameter[i] = d;
+    }
+    for (int i = 0; i < NoseN; i++) {
+        sample_t d = (sample_t) this->noseDiameter[i];
+        changed |= this->tractProps->noseDiameter[i] != d;
+        this->tractProps->noseDiameter[i] = d;
+    }
+    if (changed) this->tractProps->shapeVersion++;
+}
+
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::addTransient(int position)
 {
     if (this->transientCount < MAX_TRANSIENTS) {
         t_transient *trans = nullptr;
         for (int i = 0; i < MAX_TRANSIENTS; i++) {
-            trans = this->transients + i;
+            trans = &this->transients[i];
             if (trans->living == false) break;
         }
         if (trans) {
@@ -156,129 +222,170 @@ void Tract::addTransient(int position)
             trans->strength = 0.3;
             trans->exponent = 200;
             trans->living = true;
+            if (this->log) this->log->push(LOG_TRANSIENT, (float) position);
         }
         this->transientCount++;
     }
 }
 
-void Tract::addTurbulenceNoise(sample_t turbulenceNoise, sample_t glottalNoiseModulator)
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::addTurbulenceNoise(Sample turbulenceNoise, Sample glottalNoiseModulator)
 {
-    if (this->constrictionIndex < 2.0 || this->constrictionIndex > (sample_t) this->tractProps->n) {
-        return;
+    Sample noise = turbulenceNoise * glottalNoiseModulator;
+    for (int k = 0; k < this->turbulenceCount; k++)
+    {
+        const typename State::TurbulenceSource &source = this->turbulenceSources[k];
+        Sample noise0 = noise * source.gain0;
+        Sample noise1 = noise * source.gain1;
+        this->R[source.section] += noise0;
+        this->L[source.section] += noise0;
+        this->R[source.section + 1] += noise1;
+        this->L[source.section + 1] += noise1;
     }
-    if (this->constrictionDiameter <= 0.0) return;
-    sample_t intensity = this->fricativeIntensity;
-    this->addTurbulenceNoiseAtIndex(0.66 * turbulenceNoise * intensity, this->constrictionIndex, this->constrictionDiameter, glottalNoiseModulator);
 }
 
-void Tract::addTurbulenceNoiseAtIndex(sample_t turbulenceNoise, sample_t index, sample_t diameter, sample_t glottalNoiseModulator)
+// Control-rate half of the turbulence: everything but the noise sample itself
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::updateTurbulenceSources()
 {
-    long i = (long) floor(index);
-    sample_t delta = index - (sample_t) i;
-    turbulenceNoise *= glottalNoiseModulator;
-    sample_t thinness0 = clamp(8.0 * (0.7 - diameter), 0.0, 1.0);
-    sample_t openness = clamp(30.0 * (diameter - 0.3), 0.0, 1.0);
-    sample_t noise0 = turbulenceNoise * (1.0 - delta) * thinness0 * openness;
-    sample_t noise1 = turbulenceNoise * delta * thinness0 * openness;
-    this->R[i + 1] += noise0 / 2.0;
-    this->L[i + 1] += noise0 / 2.0;
-    this->R[i + 2] += noise1 / 2.0;
-    this->L[i + 2] += noise1 / 2.0;
-}
-
-void Tract::calculateReflections()
+    this->turbulenceCount = 0;
+    for (const t_constriction &c : this->constrictions)
+    {
+        if (c.fricative <= 0 || c.index < 2.0 || c.index > (Sample) N || c.diameter <= 0.0) continue;
+        long i = (long) floor(c.index);
+        Sample delta = c.index - (Sample) i;
+        Sample thinness0 = clampT<Sample>(8.0 * (0.7 - c.diameter), 0.0, 1.0);
+        Sample openness = clampT<Sample>(30.0 * (c.diameter - 0.3), 0.0, 1.0);
+        Sample gain = 0.66 * c.fricative * thinness0 * openness / 2.0;
+        if (gain == 0) continue;
+
+        typename State::TurbulenceSource &source = this->turbulenceSources[this->turbulenceCount];
+        source.section = (int) i + 1;
+        source.gain0 = gain * (1.0 - delta);
+        source.gain1 = gain * delta;
+        // Noise past the lips has nowhere to go
+        if (source.section >= N) continue;
+        if (source.section == N - 1) {
+            source.section = N - 2;
+            source.gain1 = source.gain0;
+            source.gain0 = 0;
+        }
+        this->turbulenceCount++;
+    }
+}
+
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::calculateReflections()
 {
-    for (int i = 0; i < this->tractProps->n; i++)
+    for (int i = 0; i < N; i++)
     {
         this->A[i] = this->diameter[i] * this->diameter[i]; //ignoring PI etc.
     }
-    for (int i=1; i<this->tractProps->n; i++)
+    for (int i = 1; i < N; i++)
     {
         this->reflection[i] = this->newReflection[i];
         if (this->A[i] == 0) this->newReflection[i] = 0.999; //to prevent some bad behaviour if 0
         else this->newReflection[i] = (this->A[i-1]-this->A[i]) / (this->A[i-1]+this->A[i]);
     }
-    
+
     //now at junction with nose
     this->reflectionLeft = this->newReflectionLeft;
     this->reflectionRight = this->newReflectionRight;
     this->reflectionNose = this->newReflectionNose;
-    sample_t sum = this->A[this->tractProps->noseStart] + this->A[this->tractProps->noseStart + 1] + this->noseA[0];
-    this->newReflectionLeft = (2.0 * this->A[this->tractProps->noseStart] - sum) / sum;
-    this->newReflectionRight = (2 * this->A[this->tractProps->noseStart + 1] - sum) / sum;
+    Sample sum = this->A[noseStart] + this->A[noseStart + 1] + this->noseA[0];
+    this->newReflectionLeft = (2.0 * this->A[noseStart] - sum) / sum;
+    this->newReflectionRight = (2 * this->A[noseStart + 1] - sum) / sum;
     this->newReflectionNose = (2 * this->noseA[0] - sum) / sum;
 }
 
-void Tract::calculateNoseReflections()
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::calculateNoseReflections()
 {
-    for (int i = 0; i < this->tractProps->noseLength; i++)
+    for (int i = 0; i < NoseN; i++)
     {
         this->noseA[i] = this->noseDiameter[i] * this->noseDiameter[i];
     }
-    for (int i = 1; i < this->tractProps->noseLength; i++)
+    for (int i = 1; i < NoseN; i++)
     {
         this->noseReflection[i] = (this->noseA[i - 1] - this->noseA[i]) / (this->noseA[i - 1] + this->noseA[i]);
     }
 }
 
-void Tract::finishBlock()
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::finishBlock()
 {
+    PROFILE_SCOPE(this->profiler, PROFILE_RESHAPE);
+    this->applyConstrictions();
     this->reshapeTract(this->blockTime);
     this->calculateReflections();
-    memcpy(this->tractProps->tractDiameter, this->diameter, sizeof(sample_t) * this->tractProps->n);
-    memcpy(this->tractProps->noseDiameter, this->noseDiameter, sizeof(sample_t) * this->tractProps->noseLength);
+    this->updateNoseBypass();
+    this->copyDiameters();
 }
-/*
-void Tract::setRestDiameter(sample_t tongueIndex, sample_t tongueDiameter)
+
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::updateNoseBypass()
 {
-    this->tractProps->tongueIndex = tongueIndex;
-    this->tractProps->tongueDiameter = tongueDiameter;
-    
-    // Calculate tongue shape - THIS WAS MISSING!
-    for (long i = this->tractProps->bladeStart; i < this->tractProps->lipStart; i++)
-    {
-        sample_t t = 1.1 * M_PI * (sample_t) (tongueIndex - i) / (sample_t) (this->tractProps->tipStart - this->tractProps->bladeStart);
-        sample_t fixedTongueDiameter = 2 + (tongueDiameter - 2) / 1.5;
-        sample_t curve = (1.5 - fixedTongueDiameter + 1.7) * cos(t);
-        if (i == this->tractProps->bladeStart-2 || i == this->tractProps->lipStart-1) curve *= 0.8;
-        if (i == this->tractProps->bladeStart || i == this->tractProps->lipStart-2) curve *= 0.94;
-        this->restDiameter[i] = 1.5 - curve;
+    if (!this->nasalBypass || this->noseDiameter[0] > NOSE_BYPASS_DIAMETER) {
+        this->noseBypassed = false;
+        return;
+    }
+    if (this->noseBypassed) return;
+
+    // Wait for the nose to ring out before cutting it off. A closed velum
+    // still leaks a little of the oral wave into the nose, so the nose only
+    // has to be quiet relative to the mouth.
+    Sample noseEnergy = 0;
+    for (int i = 0; i < NoseN; i++) {
+        noseEnergy += this->noseR[i] * this->noseR[i] + this->noseL[i] * this->noseL[i];
+    }
+    Sample oralEnergy = 0;
+    for (int i = 0; i < N; i++) {
+        oralEnergy += this->R[i] * this->R[i] + this->L[i] * this->L[i];
+    }
+    if (noseEnergy >= NOSE_BYPASS_ENERGY && noseEnergy >= NOSE_BYPASS_RATIO * oralEnergy) return;
+
+    this->noseR.fill(0);
+    this->noseL.fill(0);
+    this->noseJunctionOutputR.fill(0);
+    this->noseJunctionOutputL.fill(0);
+    this->noseOutput = 0;
+    this->noseBypassed = true;
+}
+
+template <int N, int NoseN, typename Sample>
+bool BasicTract<N, NoseN, Sample>::isStable()
+{
+    Sample energy = 0;
+    for (int i = 0; i < N; i++) {
+        energy += this->R[i] * this->R[i] + this->L[i] * this->L[i];
     }
-    for (long i = 0; i < this->tractProps->n; i++) {
-        this->targetDiameter[i] = this->restDiameter[i];
-        // IMPORTANT: Also immediately update the current diameter for instant visual feedback
-        this->diameter[i] = this->restDiameter[i];
+    for (int i = 0; i < NoseN; i++) {
+        energy += this->noseR[i] * this->noseR[i] + this->noseL[i] * this->noseL[i];
     }
-    
-    // CRITICAL: Immediately copy to the visualization array
-    memcpy(this->tractProps->tractDiameter, this->diameter, sizeof(sample_t) * this->tractProps->n);
+    // NaN fails the comparison as well
+    return energy < (Sample) HEALTH_ENERGY_LIMIT;
 }
-*/
 
-void Tract::setRestDiameter(sample_t tongueIndex, sample_t tongueDiameter)
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::setRestDiameter(sample_t tongueIndex, sample_t tongueDiameter, bool immediate)
 {
     this->tractProps->tongueIndex = tongueIndex;
     this->tractProps->tongueDiameter = tongueDiameter;
-    
+
     // Calculate tongue shape - THIS WAS MISSING!
-    for (long i = this->tractProps->bladeStart; i < this->tractProps->lipStart; i++)
+    for (int i = bladeStart; i < lipStart; i++)
     {
-        sample_t t = 1.1 * M_PI * (sample_t) (tongueIndex - i) / (sample_t) (this->tractProps->tipStart - this->tractProps->bladeStart);
-        sample_t fixedTongueDiameter = 2 + (tongueDiameter - 2) / 1.5;
-        sample_t curve = (1.5 - fixedTongueDiameter + 1.7) * cos(t);
-        if (i == this->tractProps->bladeStart-2 || i == this->tractProps->lipStart-1) curve *= 0.8;
-        if (i == this->tractProps->bladeStart || i == this->tractProps->lipStart-2) curve *= 0.94;
+        Sample t = 1.1 * M_PI * (Sample) (tongueIndex - i) / (Sample) (tipStart - bladeStart);
+        Sample fixedTongueDiameter = 2 + (tongueDiameter - 2) / 1.5;
+        Sample curve = (1.5 - fixedTongueDiameter + 1.7) * cos(t);
+        if (i == bladeStart-2 || i == lipStart-1) curve *= 0.8;
+        if (i == bladeStart || i == lipStart-2) curve *= 0.94;
         this->restDiameter[i] = 1.5 - curve;
     }
-    for (long i = 0; i < this->tractProps->n; i++) {
-        this->targetDiameter[i] = this->restDiameter[i];
-        // IMPORTANT: Also immediately update the current diameter for instant visual feedback
-        this->diameter[i] = this->restDiameter[i];
-    }
-    
+
     // Update nose cavity based on tongue position (simple mapping for demo)
     // When tongue is high and back, open the nose more (like for nasal sounds)
-    sample_t noseOpenness = 0.01; // Default closed
+    Sample noseOpenness = 0.01; // Default closed
     if (tongueIndex > 20.0 && tongueDiameter < 2.5) {
         // High back tongue position - open nose more
         noseOpenness = 0.4;
@@ -286,136 +393,136 @@ void Tract::setRestDiameter(sample_t tongueIndex, sample_t tongueDiameter)
         // Moderate position - slightly open
         noseOpenness = 0.2;
     }
-    
-    // Update nose diameter immediately
-    this->noseDiameter[0] = noseOpenness;
-    this->velumTarget = noseOpenness;
-    this->noseA[0] = this->noseDiameter[0] * this->noseDiameter[0];
-    
-    // CRITICAL: Immediately copy to the visualization arrays
-    memcpy(this->tractProps->tractDiameter, this->diameter, sizeof(sample_t) * this->tractProps->n);
-    memcpy(this->tractProps->noseDiameter, this->noseDiameter, sizeof(sample_t) * this->tractProps->noseLength);
+    this->restVelum = noseOpenness;
+
+    this->shapeChanged = true;
+    if (immediate) this->snapToTarget();
 }
 
-/*
-void Tract::setRestDiameter(sample_t tongueIndex, sample_t tongueDiameter)
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::setRestShape(const sample_t *restDiameter, sample_t velum, bool immediate)
 {
-    this->tractProps->tongueIndex = tongueIndex;
-    this->tractProps->tongueDiameter = tongueDiameter;
-    
-    // Calculate tongue shape - THIS WAS MISSING!
-    for (long i = this->tractProps->bladeStart; i < this->tractProps->lipStart; i++)
-    {
-        sample_t t = 1.1 * M_PI * (sample_t) (tongueIndex - i) / (sample_t) (this->tractProps->tipStart - this->tractProps->bladeStart);
-        sample_t fixedTongueDiameter = 2 + (tongueDiameter - 2) / 1.5;
-        sample_t curve = (1.5 - fixedTongueDiameter + 1.7) * cos(t);
-        if (i == this->tractProps->bladeStart-2 || i == this->tractProps->lipStart-1) curve *= 0.8;
-        if (i == this->tractProps->bladeStart || i == this->tractProps->lipStart-2) curve *= 0.94;
-        this->restDiameter[i] = 1.5 - curve;
+    for (int i = 0; i < N; i++) {
+        this->restDiameter[i] = restDiameter[i];
     }
-    for (long i = 0; i < this->tractProps->n; i++) {
-        this->targetDiameter[i] = this->restDiameter[i];
-        // IMPORTANT: Also immediately update the current diameter for instant visual feedback
-        this->diameter[i] = this->restDiameter[i];
-    }
-    
-    // Update nose cavity based on tongue position (simple mapping for demo)
-    // When tongue is high and back, open the nose more (like for nasal sounds)
-    sample_t noseOpenness = 0.01; // Default closed
-    sample_t noseScale = 1.0; // Default size multiplier
-    
-    if (tongueIndex > 20.0 && tongueDiameter < 2.5) {
-        // High back tongue position - open nose more
-        noseOpenness = 1.5;  // Much larger opening
-        noseScale = 1.8;     // Make entire nose bigger
-    } else if (tongueIndex > 15.0 && tongueDiameter < 3.0) {
-        // Moderate position - slightly open
-        noseOpenness = 0.8;
-        noseScale = 1.4;
-    } else {
-        noseOpenness = 0.01;
-        noseScale = 0.6;  // Make nose smaller when closed
-    }
-    
-    // Update the entire nose shape, not just the opening
-    for (int i = 0; i < this->tractProps->noseLength; i++) {
-        sample_t diameter;
-        sample_t d = 2.0 * ((sample_t) i / (sample_t) this->tractProps->noseLength);
-        if (d < 1.0) diameter = 0.4 + 1.6 * d;
-        else diameter = 0.5 + 1.5 * (2.0 - d);
-        diameter = fmin(diameter, 1.9);
-        
-        // Apply scaling and opening
-        if (i == 0) {
-            this->noseDiameter[i] = noseOpenness; // Control the velum opening
-        } else {
-            this->noseDiameter[i] = diameter * noseScale; // Scale the rest
+    this->restVelum = velum;
+    this->shapeChanged = true;
+    if (immediate) this->snapToTarget();
+}
+
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::setConstriction(int slot, const t_constriction &constriction)
+{
+    if (slot < 0 || slot >= MAX_CONSTRICTIONS) return;
+    t_constriction &c = this->constrictions[slot];
+    if (c.index == constriction.index && c.diameter == constriction.diameter
+        && c.fricative == constriction.fricative) return;
+    c = constriction;
+    this->shapeChanged = true;
+    this->updateTurbulenceSources();
+}
+
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::clearConstriction(int slot)
+{
+    t_constriction none = { -1, 1, 0 };
+    this->setConstriction(slot, none);
+}
+
+// Raised-cosine profile 0.5 * (1 - cos(pi * x)) over 0 <= x <= 1, tabulated
+// once so that shaping a constriction costs no cos() calls
+static const sample_t *constrictionWindow()
+{
+    static const std::array<sample_t, CONSTRICTION_WINDOW_SIZE + 2> table = [] {
+        std::array<sample_t, CONSTRICTION_WINDOW_SIZE + 2> t;
+        for (int i = 0; i <= CONSTRICTION_WINDOW_SIZE; i++) {
+            t[i] = (sample_t) (0.5 * (1 - cos(M_PI * i / CONSTRICTION_WINDOW_SIZE)));
         }
-    }
-    
-    this->velumTarget = noseOpenness;
-    this->noseA[0] = this->noseDiameter[0] * this->noseDiameter[0];
-    
-    // CRITICAL: Immediately copy to the visualization arrays
-    memcpy(this->tractProps->tractDiameter, this->diameter, sizeof(sample_t) * this->tractProps->n);
-    memcpy(this->tractProps->noseDiameter, this->noseDiameter, sizeof(sample_t) * this->tractProps->noseLength);
+        t[CONSTRICTION_WINDOW_SIZE + 1] = 1;  // guard for x == 1
+        return t;
+    }();
+    return table.data();
 }
-*/
-void Tract::setConstriction(sample_t cindex, sample_t cdiam, sample_t fricativeIntensity)
+
+// Rebuilds targetDiameter and velumTarget from the rest shape and the
+// constrictions. This is basically the Tract touch handling code, once per
+// constriction; each can only narrow what the others left.
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::applyConstrictions()
 {
-    this->constrictionIndex = cindex;
-    this->constrictionDiameter = cdiam;
-    this->fricativeIntensity = fricativeIntensity;
-    
-    // This is basically the Tract touch handling code
-    this->velumTarget = 0.01;
-    if (this->constrictionIndex > this->tractProps->noseStart && this->constrictionDiameter < -this->tractProps->noseOffset)
-    {
-        this->velumTarget = 0.4;
-    }
-    if (this->constrictionDiameter < -0.85 - this->tractProps->noseOffset) {
-        return;
-    }
-    
-    sample_t diameter = this->constrictionDiameter - 0.3;
-    if (diameter < 0) diameter = 0;
-    long width = 2;
-    if (this->constrictionIndex < 25) width = 10;
-    else if (this->constrictionIndex >= this->tractProps->tipStart) width= 5;
-    else width = 10.0 - 5 * (this->constrictionIndex - 25) / ((sample_t) this->tractProps->tipStart - 25.0);
-    if (this->constrictionIndex >= 2 && this->constrictionIndex < this->tractProps->n && diameter < 3)
+    if (!this->shapeChanged) return;
+    this->shapeChanged = false;
+    this->targetDiameter = this->restDiameter;
+    this->velumTarget = this->restVelum;
+
+    const sample_t *window = constrictionWindow();
+    for (const t_constriction &c : this->constrictions)
     {
-        long intIndex = round(this->constrictionIndex);
+        if (c.index > noseStart && c.diameter < -this->tractProps->noseOffset)
+        {
+            this->velumTarget = 0.4;
+        }
+        if (c.diameter < -0.85 - this->tractProps->noseOffset) continue;
+
+        Sample diameter = c.diameter - 0.3;
+        if (diameter < 0) diameter = 0;
+        long width;
+        if (c.index < 25) width = 10;
+        else if (c.index >= tipStart) width = 5;
+        else width = 10.0 - 5 * (c.index - 25) / ((Sample) tipStart - 25.0);
+        if (!(c.index >= 2 && c.index < N && diameter < 3)) continue;
+
+        long intIndex = lround(c.index);
+        Sample scale = CONSTRICTION_WINDOW_SIZE / (Sample) width;
         for (long i = -ceil(width) - 1; i < width + 1; i++)
         {
-            if (intIndex + i < 0 || intIndex + i >= this->tractProps->n) continue;
-            sample_t relpos = (intIndex + i) - this->constrictionIndex;
-            relpos = abs(relpos) - 0.5;
-            sample_t shrink;
+            if (intIndex + i < 0 || intIndex + i >= N) continue;
+            Sample relpos = std::abs((intIndex + i) - c.index) - 0.5;
+            Sample shrink;
             if (relpos <= 0) shrink = 0;
             else if (relpos > width) shrink = 1;
-            else shrink = 0.5 * (1 - cos(M_PI * relpos / (sample_t) width));
-            if (diameter < this->targetDiameter[intIndex + i])
+            else {
+                Sample x = relpos * scale;
+                int k = (int) x;
+                shrink = window[k] + (window[k + 1] - window[k]) * (x - k);
+            }
+            Sample &target = this->targetDiameter[intIndex + i];
+            if (diameter < target)
             {
-                this->targetDiameter[intIndex + i] = diameter + (this->targetDiameter[intIndex + i] - diameter) * shrink;
+                target = diameter + (target - diameter) * shrink;
             }
         }
     }
 }
 
-void Tract::processTransients()
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::snapToTarget()
+{
+    this->applyConstrictions();
+    this->diameter = this->targetDiameter;
+    this->noseDiameter[0] = this->velumTarget;
+    this->noseA[0] = this->noseDiameter[0] * this->noseDiameter[0];
+    this->copyDiameters();
+}
+
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::processTransients()
 {
     for (int i = 0; i < this->transientCount; i++)
     {
-        t_transient *trans = this->transients + i;
-        sample_t amplitude = trans->strength * pow(2.0, -trans->exponent * trans->timeAlive);
+        t_transient *trans = &this->transients[i];
+        Sample amplitude;
+        if (this->mathQuality == MATH_QUALITY_FAST)
+            amplitude = trans->strength * fastExp2(-trans->exponent * trans->timeAlive);
+        else
+            amplitude = trans->strength * pow(2.0, -trans->exponent * trans->timeAlive);
         this->R[trans->position] += amplitude / 2.0;
         this->L[trans->position] += amplitude / 2.0;
         trans->timeAlive += 1.0 / (this->sampleRate * 2.0);
     }
     for (int i = this->transientCount - 1; i >= 0; i--)
     {
-        t_transient *trans = this->transients + i;
+        t_transient *trans = &this->transients[i];
         if (trans->timeAlive > trans->lifeTime)
         {
             trans->living = false;
@@ -423,105 +530,128 @@ void Tract::processTransients()
     }
 }
 
-void Tract::reshapeTract(sample_t deltaTime)
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::reshapeTract(Sample deltaTime)
 {
-    sample_t amount = deltaTime * this->movementSpeed; ;
+    Sample amount = deltaTime * this->movementSpeed;
     int newLastObstruction = -1;
-    for (int i = 0; i < this->tractProps->n; i++)
+    for (int i = 0; i < N; i++)
     {
-        sample_t diameter = this->diameter[i];
-        sample_t targetDiameter = this->targetDiameter[i];
+        Sample diameter = this->diameter[i];
+        Sample targetDiameter = this->targetDiameter[i];
         if (diameter <= 0) newLastObstruction = i;
-        sample_t slowReturn;
-        if (i < this->tractProps->noseStart) slowReturn = 0.6;
-        else if (i >= this->tractProps->tipStart) slowReturn = 1.0;
-        else slowReturn = 0.6 + 0.4 * (i - this->tractProps->noseStart) / (this->tractProps->tipStart - this->tractProps->noseStart);
-        this->diameter[i] = moveTowards(diameter, targetDiameter, slowReturn*amount, 2*amount);
+        Sample slowReturn;
+        if (i < noseStart) slowReturn = 0.6;
+        else if (i >= tipStart) slowReturn = 1.0;
+        else slowReturn = 0.6 + 0.4 * (i - noseStart) / (tipStart - noseStart);
+        this->diameter[i] = moveTowardsT<Sample>(diameter, targetDiameter, slowReturn*amount, 2*amount);
     }
     if (this->lastObstruction > -1 && newLastObstruction == -1 && this->noseA[0]<0.05)
     {
         this->addTransient(this->lastObstruction);
     }
     this->lastObstruction = newLastObstruction;
-    
+
     amount = deltaTime * this->movementSpeed;
-    this->noseDiameter[0] = moveTowards(this->noseDiameter[0], this->velumTarget, amount * 0.25, amount * 0.1);
-    this->tractProps->noseDiameter[0] = this->noseDiameter[0];
+    this->noseDiameter[0] = moveTowardsT<Sample>(this->noseDiameter[0], this->velumTarget, amount * 0.25, amount * 0.1);
     this->noseA[0] = this->noseDiameter[0] * this->noseDiameter[0];
 }
 
-void Tract::runStep(sample_t glottalOutput, sample_t turbulenceNoise, sample_t lambda, sample_t glottalNoiseModulator)
+template <int N, int NoseN, typename Sample>
+void BasicTract<N, NoseN, Sample>::runStep(sample_t glottalOutput, sample_t turbulenceNoise, sample_t lambda, sample_t glottalNoiseModulator)
 {
-    sample_t updateAmplitudes = ((sample_t) rand() / (sample_t) RAND_MAX) < 0.1;
-    
+    PROFILE_SCOPE(this->profiler, PROFILE_TRACT);
+    bool updateAmplitudes = randomUnit(&this->random) < 0.1;
+
     //mouth
-    this->processTransients();
-    this->addTurbulenceNoise(turbulenceNoise, glottalNoiseModulator);
-    
-    //this->glottalReflection = -0.8 + 1.6 * Glottis.newTenseness;
-    this->junctionOutputR[0] = this->L[0] * this->glottalReflection + glottalOutput;
-    this->junctionOutputL[this->tractProps->n] = this->R[this->tractProps->n-1] * this->lipReflection;
-    
-    for (int i = 1; i < this->tractProps->n; i++)
     {
-        sample_t r = this->reflection[i] * (1-lambda) + this->newReflection[i]*lambda;
-        sample_t w = r * (this->R[i - 1] + this->L[i]);
-        this->junctionOutputR[i] = this->R[i - 1] - w;
-        this->junctionOutputL[i] = this->L[i] + w;
+        PROFILE_SCOPE(this->profiler, PROFILE_TRANSIENTS);
+        this->processTransients();
     }
-    
-    //now at junction with nose
-    int i = this->tractProps->noseStart;
-    sample_t r = this->newReflectionLeft * (1 - lambda) + this->reflectionLeft * lambda;
-    this->junctionOutputL[i] = r * this->R[i - 1] + (1 + r) * (this->noseL[0] + this->L[i]);
-    r = this->newReflectionRight * (1 - lambda) + this->reflectionRight * lambda;
-    this->junctionOutputR[i] = r * this->L[i] + (1 + r) * (this->R[i - 1] + this->noseL[0]);
-    r = this->newReflectionNose * (1 - lambda) + this->reflectionNose * lambda;
-    this->noseJunctionOutputR[0] = r * this->noseL[0] + (1 + r) * (this->L[i] + this->R[i - 1]);
-    
-    for (int i=0; i < this->tractProps->n; i++)
     {
-        this->R[i] = this->junctionOutputR[i] * 0.999;
-        this->L[i] = this->junctionOutputL[i + 1] * 0.999;
-        
-        //this->R[i] = Math.clamp(this->junctionOutputR[i] * this->fade, -1, 1);
-        //this->L[i] = Math.clamp(this->junctionOutputL[i+1] * this->fade, -1, 1);
-        
-        if (updateAmplitudes)
+        PROFILE_SCOPE(this->profiler, PROFILE_TURBULENCE);
+        this->addTurbulenceNoise(turbulenceNoise, glottalNoiseModulator);
+    }
+
+    {
+        PROFILE_SCOPE(this->profiler, PROFILE_SCATTERING);
+        //this->glottalReflection = -0.8 + 1.6 * Glottis.newTenseness;
+        this->junctionOutputR[0] = this->L[0] * this->glottalReflection + glottalOutput;
+        this->junctionOutputL[N] = this->R[N - 1] * this->lipReflection;
+
+        for (int i = 1; i < N; i++)
         {
-            sample_t amplitude = fabs(this->R[i] + this->L[i]);
-            if (amplitude > this->maxAmplitude[i]) this->maxAmplitude[i] = amplitude;
-            else this->maxAmplitude[i] *= 0.999;
+            Sample r = this->reflection[i] * (1-lambda) + this->newReflection[i]*lambda;
+            Sample w = r * (this->R[i - 1] + this->L[i]);
+            this->junctionOutputR[i] = this->R[i - 1] - w;
+            this->junctionOutputL[i] = this->L[i] + w;
         }
+
+        //now at junction with nose
+        int i = noseStart;
+        Sample r = this->newReflectionLeft * (1 - lambda) + this->reflectionLeft * lambda;
+        this->junctionOutputL[i] = r * this->R[i - 1] + (1 + r) * (this->noseL[0] + this->L[i]);
+        r = this->newReflectionRight * (1 - lambda) + this->reflectionRight * lambda;
+        this->junctionOutputR[i] = r * this->L[i] + (1 + r) * (this->R[i - 1] + this->noseL[0]);
+        if (!this->noseBypassed) {
+            r = this->newReflectionNose * (1 - lambda) + this->reflectionNose * lambda;
+            this->noseJunctionOutputR[0] = r * this->noseL[0] + (1 + r) * (this->L[i] + this->R[i - 1]);
+        }
+
+        for (int i = 0; i < N; i++)
+        {
+            this->R[i] = this->junctionOutputR[i] * 0.999;
+            this->L[i] = this->junctionOutputL[i + 1] * 0.999;
+
+            //this->R[i] = Math.clamp(this->junctionOutputR[i] * this->fade, -1, 1);
+            //this->L[i] = Math.clamp(this->junctionOutputL[i+1] * this->fade, -1, 1);
+
+            if (updateAmplitudes)
+            {
+                Sample amplitude = fabs(this->R[i] + this->L[i]);
+                if (amplitude > this->maxAmplitude[i]) this->maxAmplitude[i] = amplitude;
+                else this->maxAmplitude[i] *= 0.999;
+            }
+        }
+
+        this->lipOutput = this->R[N - 1];
     }
-    
-    this->lipOutput = this->R[this->tractProps->n - 1];
-    
+
+    // While bypassed noseL[0] stays at zero, which leaves the nose junction
+    // above acting as a plain oral junction
+    if (this->noseBypassed) return;
+
     //nose
-    this->noseJunctionOutputL[this->tractProps->noseLength] = this->noseR[this->tractProps->noseLength - 1] * this->lipReflection;
-    
-    for (int i=1; i < this->tractProps->noseLength; i++)
+    PROFILE_SCOPE(this->profiler, PROFILE_NOSE);
+    this->noseJunctionOutputL[NoseN] = this->noseR[NoseN - 1] * this->lipReflection;
+
+    for (int i = 1; i < NoseN; i++)
     {
-        int w = this->noseReflection[i] * (this->noseR[i - 1] + this->noseL[i]);
+        Sample w = this->noseReflection[i] * (this->noseR[i - 1] + this->noseL[i]);
         this->noseJunctionOutputR[i] = this->noseR[i - 1] - w;
         this->noseJunctionOutputL[i] = this->noseL[i] + w;
     }
-    
-    for (int i=0; i < this->tractProps->noseLength; i++)
+
+    for (int i = 0; i < NoseN; i++)
     {
         this->noseR[i] = this->noseJunctionOutputR[i] * this->fade;
         this->noseL[i] = this->noseJunctionOutputL[i + 1] * this->fade;
-        
+
         //this->noseR[i] = Math.clamp(this->noseJunctionOutputR[i] * this->fade, -1, 1);
         //this->noseL[i] = Math.clamp(this->noseJunctionOutputL[i+1] * this->fade, -1, 1);
-        
+
         if (updateAmplitudes)
         {
-            sample_t amplitude = fabs(this->noseR[i] + this->noseL[i]);
+            Sample amplitude = fabs(this->noseR[i] + this->noseL[i]);
             if (amplitude > this->noseMaxAmplitude[i]) this->noseMaxAmplitude[i] = amplitude;
             else this->noseMaxAmplitude[i] *= 0.999;
         }
     }
-    
-    this->noseOutput = this->noseR[this->tractProps->noseLength - 1];
+
+    this->noseOutput = this->noseR[NoseN - 1];
 }
+
+template class BasicTract<44, 28, float>;
+template class BasicTract<44, 28, double>;
+template class BasicTract<22, 14, float>;
+template class BasicTract<22, 14, double>;
@@ -9,9 +9,31 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <array>
 #include "config.h"
+#include "FastMath.h"
+#include "Random.h"
 
-struct t_transient;
+class DiagnosticLog;
+class Profiler;
+
+typedef struct t_transient {
+    int position;
+    sample_t timeAlive;
+    sample_t lifeTime;
+    sample_t strength;
+    sample_t exponent;
+    bool living;
+} t_transient;
+
+// One articulator narrowing the tract. Indices below 2 or past the lips
+// leave the shape alone, as do diameters below -(0.85 + noseOffset); a
+// diameter below -noseOffset behind the nose opens the velum.
+typedef struct t_constriction {
+    sample_t index;         // in sections from the glottis
+    sample_t diameter;
+    sample_t fricative;     // turbulence intensity, 0 to 1
+} t_constriction;
 
 typedef struct t_tractProps {
     int n;
@@ -25,75 +47,215 @@ typedef struct t_tractProps {
     sample_t tongueDiameter;
     sample_t *noseDiameter;
     sample_t *tractDiameter;
+    unsigned int shapeVersion;  // bumped whenever the published diameters change
 } t_tractProps;
 
-void initializeTractProps(t_tractProps *props, int n);
+// Uses the given diameter arrays when provided, otherwise callocs them
+void initializeTractProps(t_tractProps *props, int n,
+                          sample_t *tractDiameter = nullptr, sample_t *noseDiameter = nullptr);
 
+typedef enum t_tractPrecision {
+    TRACT_PRECISION_FLOAT,
+    TRACT_PRECISION_DOUBLE
+} t_tractPrecision;
+
+// Runtime interface to a tract of any length and sample type. Tract::create
+// picks the matching BasicTract instantiation for the length in props.
 class Tract {
 public:
-    Tract(sample_t sampleRate, sample_t blockSize, t_tractProps *p);
-    ~Tract();
-    void runStep(sample_t glottalOutput, sample_t turbulenceNoise, sample_t lambda, sample_t glottalNoiseModulator);
-    void finishBlock();
-    void setRestDiameter(sample_t tongueIndex, sample_t tongueDiameter);
-    void setConstriction(sample_t cindex, sample_t cdiam, sample_t fricativeIntensity);
+    static Tract *create(sample_t sampleRate, sample_t blockTime, t_tractProps *p,
+                         t_tractPrecision precision = TRACT_PRECISION_FLOAT);
+    
+    // Placement variant: memory must hold getSize() bytes, aligned to 64.
+    // Destroy with an explicit ~Tract() call.
+    static Tract *create(void *memory, sample_t sampleRate, sample_t blockTime, t_tractProps *p,
+                         t_tractPrecision precision = TRACT_PRECISION_FLOAT);
+    static size_t getSize(int n, t_tractPrecision precision);
+    virtual ~Tract() {}
+
+    virtual void runStep(sample_t glottalOutput, sample_t turbulenceNoise, sample_t lambda, sample_t glottalNoiseModulator) = 0;
+    virtual void finishBlock() = 0;
+    // Time between finishBlock() calls, which sets how far the shape moves
+    virtual void setBlockTime(sample_t blockTime) = 0;
+    // Rest shape from the tongue model. When immediate, the tract snaps to
+    // the new shape, constrictions included, e.g. for visual feedback;
+    // otherwise it moves there at MOVEMENT_SPEED from the next finishBlock().
+    virtual void setRestDiameter(sample_t tongueIndex, sample_t tongueDiameter, bool immediate = true) = 0;
+    // Rest shape given directly as n diameters plus the velum opening, in
+    // place of the tongue model; setRestDiameter() switches back to it.
+    virtual void setRestShape(const sample_t *restDiameter, sample_t velum, bool immediate = true) = 0;
+
+    // Up to MAX_CONSTRICTIONS articulators, e.g. tongue tip and lips for "pl",
+    // narrow the tract at once. finishBlock() rebuilds the target shape from
+    // the rest shape and every constriction whenever one of them changed, and
+    // each fricative constriction adds its own turbulence in runStep().
+    virtual void setConstriction(int slot, const t_constriction &constriction) = 0;
+    virtual void clearConstriction(int slot) = 0;
+    // Slot 0
+    void setConstriction(sample_t cindex, sample_t cdiam, sample_t fricativeIntensity) {
+        t_constriction constriction = { cindex, cdiam, fricativeIntensity };
+        this->setConstriction(0, constriction);
+    }
+    virtual t_tractPrecision getPrecision() = 0;
+    
+    // Complete DSP state as a flat block of getStateSize() bytes, for
+    // snapshots and for cloning into another tract of the same type
+    virtual size_t getStateSize() = 0;
+    virtual void saveState(void *state) = 0;
+    virtual void restoreState(const void *state) = 0;
+    
     sample_t lipOutput;
     sample_t noseOutput;
-    
+
     long getTractIndexCount();
     long tongueIndexLowerBound();
     long tongueIndexUpperBound();
-    
+
+    void setDiagnosticLog(DiagnosticLog *log) { this->log = log; }
+    // Stage timers for runStep() and finishBlock(), see PINK_TROMBONE_PROFILE
+    void setProfiler(Profiler *profiler) { this->profiler = profiler; }
+
+    // Skip the nose waveguide while the velum is closed and the nose has
+    // fallen silent, treating the nose junction as an oral one. On by default.
+    void setNasalBypass(bool enabled) { this->nasalBypass = enabled; }
+    virtual bool isNoseBypassed() = 0;
+
+    // False once a wave has gone NaN or infinite, or the energy of the oral
+    // and nasal waves has passed HEALTH_ENERGY_LIMIT
+    virtual bool isStable() = 0;
+
+    // Seeds the generator that paces the amplitude tracking in runStep()
+    virtual void setSeed(uint32_t seed) = 0;
+
+    // Approximate the transient envelopes with FastMath in MATH_QUALITY_FAST
+    void setMathQuality(t_mathQuality quality) { this->mathQuality = quality; }
+
+protected:
+    Tract(t_tractProps *p);
+
+    t_tractProps *tractProps;
+    DiagnosticLog *log = nullptr;
+    Profiler *profiler = nullptr;
+    bool nasalBypass = true;
+    t_mathQuality mathQuality = PINK_TROMBONE_MATH_QUALITY;
+};
+
+// Everything a BasicTract changes while running. Trivially copyable, so a
+// snapshot of the tract is a single memcpy.
+template <int N, int NoseN, typename Sample>
+struct BasicTractState {
+    template <int Size> using Array = std::array<Sample, Size>;
+
+    Sample sampleRate, blockTime;
+    Sample glottalReflection;
+    Sample lipReflection;
+    int lastObstruction;
+    Sample fade;
+    Sample movementSpeed;
+    Sample velumTarget;
+    Sample restVelum;
+    bool noseBypassed;
+    std::array<t_transient, MAX_TRANSIENTS> transients;
+    int transientCount;
+    t_random random;
+
+    // Per-sample state, cache-line aligned and in the order runStep touches it
+    alignas(64) Array<N + 1> reflection;
+    alignas(64) Array<N + 1> newReflection;
+    alignas(64) Array<N> R;
+    alignas(64) Array<N> L;
+    alignas(64) Array<N + 1> junctionOutputR;
+    alignas(64) Array<N + 1> junctionOutputL;
+    alignas(64) Array<N> maxAmplitude;
+
+    alignas(64) Array<NoseN + 1> noseReflection;
+    alignas(64) Array<NoseN> noseR;
+    alignas(64) Array<NoseN> noseL;
+    alignas(64) Array<NoseN + 1> noseJunctionOutputR;
+    alignas(64) Array<NoseN + 1> noseJunctionOutputL;
+    alignas(64) Array<NoseN> noseMaxAmplitude;
+
+    // Per-block state
+    alignas(64) Array<N> diameter;
+    Array<N> restDiameter;
+    Array<N> targetDiameter;
+    Array<N> newDiameter;
+    Array<N> A;
+    Array<NoseN> noseDiameter;
+    Array<NoseN> noseA;
+
+    Sample reflectionLeft, reflectionRight, reflectionNose;
+    Sample newReflectionLeft, newReflectionRight, newReflectionNose;
+
+    // Articulators, combined with restDiameter into targetDiameter by
+    // applyConstrictions() while shapeChanged is set
+    std::array<t_constriction, MAX_CONSTRICTIONS> constrictions;
+    bool shapeChanged;
+
+    // Where each fricative constriction injects noise: gain0 into section,
+    // gain1 into the next one. Derived from constrictions.
+    struct TurbulenceSource {
+        int section;
+        Sample gain0, gain1;
+    };
+    std::array<TurbulenceSource, MAX_CONSTRICTIONS> turbulenceSources;
+    int turbulenceCount;
+
+    Sample savedLipOutput, savedNoseOutput;
+};
+
+// Tract with N oral and NoseN nasal sections, all state held in fixed-size
+// arrays of Sample so that the per-sample loops have constant trip counts.
+template <int N, int NoseN, typename Sample>
+class BasicTract final : public Tract, private BasicTractState<N, NoseN, Sample> {
+public:
+    typedef BasicTractState<N, NoseN, Sample> State;
+
+    static constexpr int n = N;
+    static constexpr int noseLength = NoseN;
+    static constexpr int bladeStart = BLADE_START * N / (int) NUM_CONSTRICTIONS;
+    static constexpr int tipStart = TIP_START * N / (int) NUM_CONSTRICTIONS;
+    static constexpr int lipStart = LIP_START * N / (int) NUM_CONSTRICTIONS;
+    static constexpr int noseStart = N - NoseN + 1;
+
+    BasicTract(sample_t sampleRate, sample_t blockTime, t_tractProps *p);
+
+    void runStep(sample_t glottalOutput, sample_t turbulenceNoise, sample_t lambda, sample_t glottalNoiseModulator) override;
+    void finishBlock() override;
+    void setBlockTime(sample_t blockTime) override { this->blockTime = blockTime; }
+    void setRestDiameter(sample_t tongueIndex, sample_t tongueDiameter, bool immediate = true) override;
+    void setRestShape(const sample_t *restDiameter, sample_t velum, bool immediate = true) override;
+    using Tract::setConstriction;
+    void setConstriction(int slot, const t_constriction &constriction) override;
+    void clearConstriction(int slot) override;
+    t_tractPrecision getPrecision() override;
+    bool isNoseBypassed() override { return this->noseBypassed; }
+    bool isStable() override;
+    void setSeed(uint32_t seed) override { randomSeed(&this->random, seed); }
+
+    size_t getStateSize() override { return sizeof(State); }
+    void saveState(void *state) override;
+    void restoreState(const void *state) override;
+
 private:
     void init();
     void addTransient(int position);
-    void addTurbulenceNoise(sample_t turbulenceNoise, sample_t glottalNoiseModulator);
-    void addTurbulenceNoiseAtIndex(sample_t turbulenceNoise, sample_t index, sample_t diameter, sample_t glottalNoiseModulator);
+    void addTurbulenceNoise(Sample turbulenceNoise, Sample glottalNoiseModulator);
+    void updateTurbulenceSources();
+    void applyConstrictions();
+    void snapToTarget();
     void calculateReflections();
     void calculateNoseReflections();
     void processTransients();
-    void reshapeTract(sample_t deltaTime);
-    
-    sample_t sampleRate, blockTime;
-    t_tractProps *tractProps;
-    sample_t glottalReflection;
-    sample_t lipReflection;
-    int lastObstruction;
-    sample_t fade;
-    sample_t movementSpeed;
-    sample_t velumTarget;
-    t_transient *transients;
-    int transientCount;
-    
-    sample_t *diameter;
-    sample_t *restDiameter;
-    sample_t *targetDiameter;
-    sample_t *newDiameter;
-    
-    sample_t *R;
-    sample_t *L;
-    sample_t *reflection;
-    sample_t *newReflection;
-    sample_t *junctionOutputR;
-    sample_t *junctionOutputL;
-    sample_t *A;
-    sample_t *maxAmplitude;
-    
-    sample_t *noseR;
-    sample_t *noseL;
-    sample_t *noseJunctionOutputR;
-    sample_t *noseJunctionOutputL;
-    sample_t *noseReflection;
-    sample_t *noseDiameter;
-    sample_t *noseA;
-    sample_t *noseMaxAmplitude;
-    
-    sample_t reflectionLeft, reflectionRight, reflectionNose;
-    sample_t newReflectionLeft, newReflectionRight, newReflectionNose;
-    
-    sample_t constrictionIndex;
-    sample_t constrictionDiameter;
-    sample_t fricativeIntensity = 0.0;
+    void reshapeTract(Sample deltaTime);
+    void updateNoseBypass();
+    void copyDiameters();
 };
 
+// Geometries instantiated in Tract.cpp
+typedef BasicTract<44, 28, float> Tract44f;
+typedef BasicTract<44, 28, double> Tract44d;
+typedef BasicTract<22, 14, float> Tract22f;
+typedef BasicTract<22, 14, double> Tract22d;
+
 #endif /* Tract_h */
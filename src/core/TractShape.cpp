@@ -0,0 +1,42 @@
+//==============================================================================
+// src/core/TractShape.cpp
+//==============================================================================
+
+#include "TractShape.h"
+#include <algorithm>
+
+TractShapeSnapshot::TractShapeSnapshot()
+    : sequence(0) {
+    memset(&this->shape, 0, sizeof(t_tractShape));
+}
+
+void TractShapeSnapshot::publish(const t_tractProps &props, sample_t sampleRate) {
+    uint32_t s = this->sequence.load(std::memory_order_relaxed);
+    this->sequence.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    int n = std::min(props.n, TRACT_SHAPE_MAX_LENGTH);
+    int noseLength = std::min(props.noseLength, TRACT_SHAPE_MAX_NOSE_LENGTH);
+    this->shape.version = props.shapeVersion;
+    this->shape.n = n;
+    this->shape.noseLength = noseLength;
+    this->shape.noseStart = props.noseStart;
+    this->shape.sampleRate = sampleRate;
+    memcpy(this->shape.diameter, props.tractDiameter, n * sizeof(sample_t));
+    memcpy(this->shape.noseDiameter, props.noseDiameter, noseLength * sizeof(sample_t));
+
+    this->sequence.store(s + 2, std::memory_order_release);
+}
+
+bool TractShapeSnapshot::read(t_tractShape &shape) const {
+    uint32_t before, after;
+    do {
+        before = this->sequence.load(std::memory_order_acquire);
+        if (before == 0) return false;
+        if (before & 1) continue;
+        memcpy(&shape, &this->shape, sizeof(t_tractShape));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = this->sequence.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+    return true;
+}
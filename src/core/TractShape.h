@@ -0,0 +1,43 @@
+//==============================================================================
+// src/core/TractShape.h
+// Copy of a tract's geometry, published by the audio thread for other threads
+//==============================================================================
+
+#ifndef TractShape_h
+#define TractShape_h
+
+#include <stdint.h>
+#include <atomic>
+#include "config.h"
+#include "Tract.h"
+
+#define TRACT_SHAPE_MAX_LENGTH (44)
+#define TRACT_SHAPE_MAX_NOSE_LENGTH (28)
+
+typedef struct t_tractShape {
+    unsigned int version;       // t_tractProps::shapeVersion at the time of the copy
+    int n;
+    int noseLength;
+    int noseStart;
+    sample_t sampleRate;
+    sample_t diameter[TRACT_SHAPE_MAX_LENGTH];
+    sample_t noseDiameter[TRACT_SHAPE_MAX_NOSE_LENGTH];
+} t_tractShape;
+
+// Seqlock with a single writer. publish() is wait-free and meant to be called
+// from the audio thread once per block when the shape version changed; read()
+// retries until it gets a copy that was not torn by a concurrent publish().
+class TractShapeSnapshot {
+public:
+    TractShapeSnapshot();
+
+    void publish(const t_tractProps &props, sample_t sampleRate);
+    // False until the first publish()
+    bool read(t_tractShape &shape) const;
+
+private:
+    std::atomic<uint32_t> sequence;
+    t_tractShape shape;
+};
+
+#endif /* TractShape_h */
@@ -0,0 +1,48 @@
+//==============================================================================
+// src/core/VoiceArena.cpp
+//==============================================================================
+
+#include "VoiceArena.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+VoiceArena::VoiceArena(size_t size, void *memory)
+    : size(align(size))
+    , used(0)
+    , owned(memory == nullptr) {
+    this->memory = static_cast<char *>(owned ? allocateAligned(this->size) : memory);
+    memset(this->memory, 0, this->size);
+}
+
+VoiceArena::~VoiceArena() {
+    if (this->owned) freeAligned(this->memory);
+}
+
+void *VoiceArena::allocate(size_t bytes) {
+    bytes = align(bytes);
+    assert(this->used + bytes <= this->size);
+    void *block = this->memory + this->used;
+    this->used += bytes;
+    return block;
+}
+
+void *VoiceArena::allocateAligned(size_t bytes) {
+#ifdef _WIN32
+    return _aligned_malloc(bytes, ARENA_ALIGNMENT);
+#else
+    void *memory = nullptr;
+    if (posix_memalign(&memory, ARENA_ALIGNMENT, bytes) != 0) return nullptr;
+    return memory;
+#endif
+}
+
+void VoiceArena::freeAligned(void *memory) {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
@@ -0,0 +1,58 @@
+//==============================================================================
+// src/core/VoiceArena.h
+// One contiguous block per voice that all of its components are placed into
+//==============================================================================
+
+#ifndef VoiceArena_h
+#define VoiceArena_h
+
+#include <assert.h>
+#include <stddef.h>
+#include <new>
+#include <utility>
+#include "config.h"
+
+#define ARENA_ALIGNMENT (64)
+
+// Bump allocator over a single 64-byte aligned block. Nothing is freed
+// individually; objects created with create() must be destroyed by hand
+// before the arena goes away.
+class VoiceArena {
+public:
+    // Allocates the block itself when memory is null
+    VoiceArena(size_t size, void *memory = nullptr);
+    ~VoiceArena();
+
+    void *allocate(size_t bytes);
+
+    template <class T>
+    T *allocateArray(long count) {
+        return static_cast<T *>(this->allocate(sizeof(T) * count));
+    }
+
+    template <class T, class... Args>
+    T *create(Args&&... args) {
+        return new (this->allocate(sizeof(T))) T(std::forward<Args>(args)...);
+    }
+
+    size_t getSize() const { return size; }
+    size_t getUsed() const { return used; }
+
+    // Size of a block once padded to the arena alignment
+    static size_t align(size_t bytes) {
+        return (bytes + ARENA_ALIGNMENT - 1) & ~(size_t) (ARENA_ALIGNMENT - 1);
+    }
+
+    static void *allocateAligned(size_t bytes);
+    static void freeAligned(void *memory);
+
+private:
+    VoiceArena(const VoiceArena &) = delete;
+    VoiceArena &operator=(const VoiceArena &) = delete;
+
+    char *memory;
+    size_t size, used;
+    bool owned;
+};
+
+#endif /* VoiceArena_h */
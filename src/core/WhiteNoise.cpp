@@ -8,20 +8,33 @@
 #include "WhiteNoise.h"
 #include <stdlib.h>
 #include <math.h>
+#include "Random.h"
 
 
-WhiteNoise::WhiteNoise(long sampleLength) {
+WhiteNoise::WhiteNoise(long sampleLength, uint32_t seed) :
+	WhiteNoise(sampleLength, (sample_t *) malloc(sampleLength * sizeof(sample_t)), seed)
+{
+	this->ownsBuffer = true;
+}
+
+WhiteNoise::WhiteNoise(long sampleLength, sample_t *buffer, uint32_t seed) {
 	this->index = 0;
 	this->size = sampleLength;
-	this->buffer = (sample_t *) malloc(sampleLength * sizeof(sample_t));
-	
+	this->buffer = buffer;
+	this->ownsBuffer = false;
+	this->fill(seed);
+}
+
+void WhiteNoise::fill(uint32_t seed) {
+	t_random random;
+	randomSeed(&random, seed);
 	for (long i = 0; i < this->size; i++) {
-		this->buffer[i] = ((sample_t) rand() / (sample_t) RAND_MAX) * 2.0 - 1.0;
+		this->buffer[i] = randomUnit(&random) * 2.0 - 1.0;
 	}
 }
 
 WhiteNoise::~WhiteNoise() {
-	free(this->buffer);
+	if (this->ownsBuffer) free(this->buffer);
 	this->buffer = nullptr;
 }
 
@@ -9,17 +9,23 @@
 #define WhiteNoise_h
 
 #include <stdio.h>
+#include <stdint.h>
 #include "config.h"
 
 class WhiteNoise {
 public:
-	WhiteNoise(long sampleLength);
+	WhiteNoise(long sampleLength, uint32_t seed = 0);
+	WhiteNoise(long sampleLength, sample_t *buffer, uint32_t seed = 0); // uses, but does not own, buffer
 	~WhiteNoise();
 	sample_t runStep();
+	void fill(uint32_t seed); // refills the buffer, the same seed gives the same noise
+	long getPosition() { return index; }
+	void setPosition(long position) { index = position % size; }
 private:
 	long index;
 	sample_t *buffer;
 	long size;
+	bool ownsBuffer;
 };
 
 #endif /* WhiteNoise_h */
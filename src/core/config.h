@@ -12,8 +12,32 @@
 //typedef double sample_t;
 typedef float sample_t;
 
+// Debug: report blocking calls (allocation, I/O, locks) made from the audio
+// thread, see RealtimeCheck.h. Never enable in release builds.
+//#define PINK_TROMBONE_REALTIME_CHECK
+
+// Time each render stage per block, see Profiler.h. Compiled out otherwise.
+//#define PINK_TROMBONE_PROFILE
+
+// Samples per internal control block: parameters, tract shape and glottis
+// are updated once per block, whatever the host buffer size
+#define CONTROL_BLOCK_SIZE		(64)
+
+// Voice health check, see PinkTrombone::setRecoveryState(): energy of the
+// waveguide above which a voice counts as unstable, and the fade back in
+// after such a voice has been reset or has switched engines
+#define HEALTH_ENERGY_LIMIT		(1e4)
+#define RECOVERY_FADE_TIME		(0.02)      // seconds
+
+// Math quality tier of new voices, MATH_QUALITY_REFERENCE or
+// MATH_QUALITY_FAST (see FastMath.h); voices can switch at runtime
+#define PINK_TROMBONE_MATH_QUALITY	MATH_QUALITY_REFERENCE
+
 // Tract properties
 #define MAX_TRANSIENTS 			(20)
+#define MAX_CONSTRICTIONS		(4)
+// Entries in the raised-cosine table that shapes each constriction
+#define CONSTRICTION_WINDOW_SIZE	(256)
 #define NUM_CONSTRICTIONS				(44.0)
 #define BLADE_START				(10)
 #define NOSE_LENGTH				(28)
@@ -35,10 +59,18 @@ typedef float sample_t;
 #define TRACT_BOUND_B			(12.0 / 44.0)
 #define TRACT_DIAMETER_B		(1.1)
 #define TRACT_DIAMETER_C		(1.5)
+// Nasal bypass: the nose loop stops while the velum is at most this wide and
+// the energy of the nose waves is below this floor, or this far (-60 dB)
+// below the energy in the oral tract
+#define NOSE_BYPASS_DIAMETER	(0.05)
+#define NOSE_BYPASS_ENERGY		(1e-10)
+#define NOSE_BYPASS_RATIO		(1e-6)
 
 // Glottis properties
 #define VIBRATO_AMOUNT			(0.005)
 //#define VIBRATO_AMOUNT			(0)
 #define VIBRATO_FREQUENCY		(6)
+// Block length the per-block glottis ramps were tuned for
+#define GLOTTIS_REFERENCE_BLOCK_TIME	(512.0 / 44100.0)
 
 #endif /* config_h */
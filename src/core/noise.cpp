@@ -41,14 +41,14 @@ static short p[] = {151,160,137,91,90,15,
 	251,34,242,193,238,210,144,12,191,179,162,241, 81,51,145,235,249,14,239,107,
 	49,192,214, 31,181,199,106,157,184, 84,204,176,115,121,50,45,127, 4,150,254,
 	138,236,205,93,222,114,67,29,24,72,243,141,128,195,78,66,215,61,156,180};
-// To remove the need for index wrapping, sample_t the permutation table length
-static int perm[512];
-static Grad gradP[512];
+// Table used by the simplex1(x) and simplex2(x, y) shorthands, shared by the
+// whole process and seeded from the clock on first use
+static t_simplex sharedSimplex;
 static bool didseed = false;
 
 // This isn't a very good seeding function, but it works ok. It supports 2^16
 // different seed values. Write something better if you need more seeds.
-static void seed(short seed) {
+void simplexSeed(t_simplex *simplex, short seed) {
 	if(seed < 256) {
 		seed |= seed << 8;
 	}
@@ -61,8 +61,9 @@ static void seed(short seed) {
 			v = p[i] ^ ((seed>>8) & 255);
 		}
 		
-		perm[i] = perm[i + 256] = v;
-		gradP[i] = gradP[i + 256] = grad3[v % 12];
+		// To remove the need for index wrapping, the tables are doubled
+		simplex->perm[i] = simplex->perm[i + 256] = v;
+		simplex->grad[i] = simplex->grad[i + 256] = v % 12;
 	}
 };
 
@@ -84,12 +85,8 @@ static sample_t F2 = 0.5 * (sqrt(3.0) - 1.0);
 static sample_t G2 = (3 - sqrt(3.0)) / 6.0;
 
 // 2D simplex noise
-sample_t simplex2(sample_t xin, sample_t yin) {
-	
-	if (!didseed) {
-		seed(timeseed());
-		didseed = true;
-	}
+sample_t simplex2(const t_simplex *simplex, sample_t xin, sample_t yin) {
+	const short *perm = simplex->perm;
 	
 	sample_t n0, n1, n2; // Noise contributions from the three corners
 	// Skew the input space to determine which simplex cell we're in
@@ -117,9 +114,9 @@ sample_t simplex2(sample_t xin, sample_t yin) {
 	// Work out the hashed gradient indices of the three simplex corners
 	i &= 255;
 	j &= 255;
-	Grad gi0 = gradP[i + perm[j]];
-	Grad gi1 = gradP[i + i1 + perm[j + j1]];
-	Grad gi2 = gradP[i + 1 + perm[j + 1]];
+	Grad gi0 = grad3[simplex->grad[i + perm[j]]];
+	Grad gi1 = grad3[simplex->grad[i + i1 + perm[j + j1]]];
+	Grad gi2 = grad3[simplex->grad[i + 1 + perm[j + 1]]];
 	// Calculate the contribution from the three corners
 	sample_t t0 = 0.5 - x0 * x0 - y0 * y0;
 	if (t0 < 0) {
@@ -147,6 +144,18 @@ sample_t simplex2(sample_t xin, sample_t yin) {
 	return 70 * (n0 + n1 + n2);
 };
 
+sample_t simplex1(const t_simplex *simplex, sample_t xin) {
+	return simplex2(simplex, xin * 1.2, -xin * 0.7);
+}
+
+sample_t simplex2(sample_t xin, sample_t yin) {
+	if (!didseed) {
+		simplexSeed(&sharedSimplex, timeseed());
+		didseed = true;
+	}
+	return simplex2(&sharedSimplex, xin, yin);
+}
+
 sample_t simplex1(sample_t xin) {
 	return simplex2(xin * 1.2, -xin * 0.7);
 }
@@ -11,7 +11,22 @@
 #include <stdio.h>
 #include "config.h"
 
+// Permutation table of one simplex noise field. Plain data, so a component can
+// own its field and snapshot it with the rest of its state.
+typedef struct t_simplex {
+	short perm[512];
+	unsigned char grad[512];
+} t_simplex;
+
+void simplexSeed(t_simplex *simplex, short seed);
+sample_t simplex1(const t_simplex *simplex, sample_t xin);
+sample_t simplex2(const t_simplex *simplex, sample_t xin, sample_t yin);
+
+// Shorthands on a process-wide field seeded from the clock
 sample_t simplex1(sample_t xin);
 sample_t simplex2(sample_t xin, sample_t yin);
 
+// Current time in milliseconds, truncated to a simplex seed
+short timeseed();
+
 #endif /* noise_h */
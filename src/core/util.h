@@ -10,6 +10,7 @@
 
 #include <random>
 #include "config.h"
+#include "Random.h"
 
 static sample_t maxf(sample_t a, sample_t b) {
 	if (a > b) return a;
@@ -39,10 +40,26 @@ static inline sample_t moveTowards(sample_t current, sample_t target, sample_t a
 	else return maxf(current - amountDown, target);
 }
 
-static inline sample_t gaussian()
+// Precision-generic versions, for code templated on its sample type
+template <typename T>
+static inline T clampT(T number, T min, T max)
+{
+	if (number < min) return min;
+	else if (number > max) return max;
+	else return number;
+}
+
+template <typename T>
+static inline T moveTowardsT(T current, T target, T amountUp, T amountDown)
+{
+	if (current < target) return current + amountUp < target ? current + amountUp : target;
+	else return current - amountDown > target ? current - amountDown : target;
+}
+
+static inline sample_t gaussian(t_random *random)
 {
 	sample_t s = 0;
-	for (int c = 0; c < 16; c++) s += (sample_t) rand() / (sample_t) RAND_MAX;
+	for (int c = 0; c < 16; c++) s += randomUnit(random);
 	return (s - 8.0) / 4.0;
 }
 
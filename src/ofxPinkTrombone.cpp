@@ -1,8 +1,12 @@
 #include "ofxPinkTrombone.h"
 #include "PinkTrombone.h"
+#include "VoiceGroup.h"
+#include "OscControl.h"
 
 ofxPinkTrombone::ofxPinkTrombone()
     : pinkTrombone(nullptr)
+    , voiceGroup(nullptr)
+    , oscControl(nullptr)
     , sampleRate(44100)
     , bufferSize(512)
     , isSetup(false) {
@@ -12,23 +16,33 @@ ofxPinkTrombone::~ofxPinkTrombone() {
     close();
 }
 
-void ofxPinkTrombone::setup(int sampleRate, int bufferSize) {
+void ofxPinkTrombone::setup(int sampleRate, int bufferSize, int internalRate) {
     this->sampleRate = sampleRate;
     this->bufferSize = bufferSize;
     
-    if (pinkTrombone) {
-        delete pinkTrombone;
-    }
+    close();
     
-    pinkTrombone = new PinkTrombone(sampleRate);
+    int voiceRate = sampleRate;
+    if (internalRate > 0 && internalRate != sampleRate) {
+        // Stereo plus the two output buses
+        voiceGroup = new VoiceGroup(internalRate, sampleRate, 4, std::max(bufferSize, 512));
+        voiceRate = voiceGroup->getInternalRate();
+    }
+    pinkTrombone = new PinkTrombone(voiceRate);
+    if (voiceGroup) voiceGroup->addVoice(pinkTrombone);
+    DiagnosticLogWriter::getShared().addLog(pinkTrombone->getDiagnosticLog());
     isSetup = true;
 }
 
 void ofxPinkTrombone::close() {
+    stopOsc();
     if (pinkTrombone) {
+        DiagnosticLogWriter::getShared().removeLog(pinkTrombone->getDiagnosticLog());
         delete pinkTrombone;
         pinkTrombone = nullptr;
     }
+    delete voiceGroup;
+    voiceGroup = nullptr;
     isSetup = false;
 }
 
@@ -39,7 +53,54 @@ void ofxPinkTrombone::synthesize(float* output, int bufferSize) {
         return;
     }
     
-    pinkTrombone->synthesize(output, bufferSize);
+    if (oscControl) {
+        oscControl->process(bufferSize, [&](int offset, int frames) {
+            render(output + offset, frames, 1, false);
+        });
+    } else {
+        render(output, bufferSize, 1, false);
+    }
+}
+
+void ofxPinkTrombone::synthesize(ofSoundBuffer& buffer, bool accumulate) {
+    if (!isSetup || !pinkTrombone) {
+        if (!accumulate) buffer.set(0.0f);
+        return;
+    }
+    
+    float* output = buffer.getBuffer().data();
+    int numChannels = buffer.getNumChannels();
+    if (oscControl) {
+        oscControl->process(buffer.getNumFrames(), [&](int offset, int frames) {
+            render(output + offset * numChannels, frames, numChannels, accumulate);
+        });
+    } else {
+        render(output, buffer.getNumFrames(), numChannels, accumulate);
+    }
+}
+
+void ofxPinkTrombone::render(float* output, int numFrames, int numChannels, bool accumulate) {
+    if (voiceGroup) voiceGroup->render(output, numFrames, numChannels, accumulate);
+    else pinkTrombone->synthesize(output, numFrames, numChannels, accumulate);
+}
+
+bool ofxPinkTrombone::startOsc(int port, const std::string& bindAddress) {
+    stopOsc();
+    if (!pinkTrombone) return false;
+    OscControl* control = new OscControl((float) sampleRate);
+    control->setVoice(0, pinkTrombone);
+    if (!control->start(port, bindAddress)) {
+        ofLogWarning("ofxPinkTrombone") << "could not listen for OSC on port " << port;
+        delete control;
+        return false;
+    }
+    oscControl = control;
+    return true;
+}
+
+void ofxPinkTrombone::stopOsc() {
+    delete oscControl;
+    oscControl = nullptr;
 }
 
 void ofxPinkTrombone::setFrequency(float frequency) {
@@ -67,7 +128,6 @@ void ofxPinkTrombone::setTonguePosition(float index, float diameter) {
                                            (float)tract->tongueIndexUpperBound());
         float clampedDiameter = ofClamp(diameter, 1.0f, 3.5f);
         
-        cout << "Setting tongue: " << clampedIndex << ", " << clampedDiameter << endl;
         pinkTrombone->setTonguePosition(clampedIndex, clampedDiameter);
     }
 }
@@ -78,12 +138,30 @@ void ofxPinkTrombone::setConstriction(float index, float diameter, float fricati
     }
 }
 
+void ofxPinkTrombone::setConstriction(int slot, float index, float diameter, float fricative) {
+    if (pinkTrombone) {
+        pinkTrombone->setConstriction(slot, index, diameter, fricative);
+    }
+}
+
 void ofxPinkTrombone::setVibrato(float amount, float frequency) {
     if (pinkTrombone) {
         pinkTrombone->setVibrato(amount, frequency);
     }
 }
 
+void ofxPinkTrombone::setPan(float pan) {
+    if (pinkTrombone) {
+        pinkTrombone->setPan(pan);
+    }
+}
+
+void ofxPinkTrombone::setOutputBuses(int lipChannel, int noseChannel) {
+    if (pinkTrombone) {
+        pinkTrombone->setOutputBuses(lipChannel, noseChannel);
+    }
+}
+
 float* ofxPinkTrombone::getTractDiameters() {
     return pinkTrombone ? pinkTrombone->getTractDiameters() : nullptr;
 }
@@ -100,29 +178,61 @@ int ofxPinkTrombone::getNoseLength() {
     return pinkTrombone ? pinkTrombone->getNoseLength() : 0;
 }
 
+const DspMetrics* ofxPinkTrombone::getMetrics() {
+    return pinkTrombone ? pinkTrombone->getMetrics() : nullptr;
+}
+
+const Profiler* ofxPinkTrombone::getProfiler() {
+    return pinkTrombone ? pinkTrombone->getProfiler() : nullptr;
+}
+
+const FormantAnalyzer* ofxPinkTrombone::getFormants() {
+    if (!pinkTrombone || !pinkTrombone->getTractShape(tractShape)) return nullptr;
+    formantAnalyzer.update(tractShape);
+    return &formantAnalyzer;
+}
+
 // Vowel presets
+void ofxPinkTrombone::setArticulation(t_articulation preset) {
+    if (pinkTrombone) {
+        pinkTrombone->setArticulation(preset);
+    }
+}
+
+void ofxPinkTrombone::morphArticulation(t_articulation from, t_articulation to, float amount) {
+    if (pinkTrombone) {
+        pinkTrombone->morphArticulation(from, to, amount);
+    }
+}
+
+void ofxPinkTrombone::captureAreaFunction(t_areaFunction& shape) {
+    if (pinkTrombone) {
+        pinkTrombone->captureAreaFunction(shape);
+    }
+}
+
 void ofxPinkTrombone::setVowelA() {
-    setTonguePosition(12.9f, 2.43f);
+    setArticulation(ARTICULATION_A);
     setConstriction(-1, 1.0f, 0.0f);
 }
 
 void ofxPinkTrombone::setVowelE() {
-    setTonguePosition(21.0f, 2.36f);
+    setArticulation(ARTICULATION_E);
     setConstriction(-1, 1.0f, 0.0f);
 }
 
 void ofxPinkTrombone::setVowelI() {
-    setTonguePosition(25.0f, 2.05f);
+    setArticulation(ARTICULATION_I);
     setConstriction(-1, 1.0f, 0.0f);
 }
 
 void ofxPinkTrombone::setVowelO() {
-    setTonguePosition(14.0f, 2.7f);
+    setArticulation(ARTICULATION_O);
     setConstriction(-1, 1.0f, 0.0f);
 }
 
 void ofxPinkTrombone::setVowelU() {
-    setTonguePosition(16.0f, 2.8f);
+    setArticulation(ARTICULATION_U);
     setConstriction(-1, 1.0f, 0.0f);
 }
 
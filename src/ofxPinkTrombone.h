@@ -6,35 +6,64 @@
 
 #include "ofMain.h"
 #include "ofSoundStream.h"
+#include "core/ArticulationPresets.h"
+#include "core/FormantAnalyzer.h"
 
 // Forward declarations
 class PinkTrombone;
+class DspMetrics;
+class VoiceGroup;
+class OscControl;
 
 class ofxPinkTrombone {
 public:
     ofxPinkTrombone();
     ~ofxPinkTrombone();
     
-    // Setup and configuration
-    void setup(int sampleRate = 44100, int bufferSize = 512);
+    // Setup and configuration. With an internalRate other than sampleRate the
+    // voice runs at that rate and is resampled to sampleRate, see VoiceGroup.
+    void setup(int sampleRate = 44100, int bufferSize = 512, int internalRate = 0);
     void close();
     
     // Main synthesis method
     void synthesize(float* output, int bufferSize);
     
+    // Render into all channels of an interleaved sound buffer, see PinkTrombone::synthesize
+    void synthesize(ofSoundBuffer& buffer, bool accumulate = false);
+    
     // Voice parameters
     void setFrequency(float frequency);           // Fundamental frequency (Hz)
     void setTenseness(float tenseness);           // Vocal cord tension (0-1)
     void setTonguePosition(float index, float diameter); // Tongue shape
     void setConstriction(float index, float diameter, float fricative = 0.0f);
+    void setConstriction(int slot, float index, float diameter, float fricative); // slots 1+ for clusters
     void setVibrato(float amount, float frequency);
     
+    // Output routing for multichannel buffers
+    void setPan(float pan);                               // -1 (left) to 1 (right)
+    void setOutputBuses(int lipChannel, int noseChannel); // -1 disables a bus
+    
     // Getters for UI/visualization
     float* getTractDiameters();
     float* getNoseDiameters();
     int getTractLength();
     int getNoseLength();
     
+    // DSP load of the voice, safe to read from the UI thread
+    const DspMetrics* getMetrics();
+    // Per-stage render times, null unless built with PINK_TROMBONE_PROFILE;
+    // getSummary() and writeChromeTrace() are safe from the UI thread
+    const Profiler* getProfiler();
+    
+    // Analytic frequency response and formants of the current tract shape,
+    // recomputed only when the shape has changed. Call from the UI thread.
+    const FormantAnalyzer* getFormants();
+    
+    // Area-function presets, see PinkTrombone::setArticulation
+    void setArticulation(t_articulation preset);
+    void morphArticulation(t_articulation from, t_articulation to, float amount);
+    void captureAreaFunction(t_areaFunction& shape);
+    
     // Presets for common sounds
     void setVowelA();
     void setVowelE();
@@ -46,8 +75,22 @@ public:
     // Real-time parameter smoothing
     void setParameterSmoothingTime(float seconds);
     
+    // Remote control of this voice, as voice 0, over OSC on a UDP port; see
+    // OscControl for the addresses. Like setup(), which stops it, call while
+    // the sound stream is not running.
+    bool startOsc(int port, const std::string& bindAddress = "");
+    void stopOsc();
+    OscControl* getOscControl() { return oscControl; }
+    
 private:
+    void render(float* output, int numFrames, int numChannels, bool accumulate);
+    
+
     PinkTrombone* pinkTrombone;
+    VoiceGroup* voiceGroup;             // only when resampling
+    OscControl* oscControl;             // only while OSC is on
+    FormantAnalyzer formantAnalyzer;
+    t_tractShape tractShape;
     int sampleRate;
     int bufferSize;
     bool isSetup;
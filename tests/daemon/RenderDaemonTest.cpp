@@ -0,0 +1,86 @@
+//==============================================================================
+// tests/daemon/RenderDaemonTest.cpp
+// Sends malformed scores to a RenderDaemon through RenderClient: each must be
+// answered with RENDER_STATUS_BAD_SCORE, and the daemon must keep serving
+//==============================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "RenderDaemon.h"
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            return 1; \
+        } \
+    } while (0)
+
+// One-voice score image in 8-byte words, laid out as Score::write() does
+static std::vector<uint64_t> makeScore(const std::vector<uint64_t> &times, uint64_t keyframeCount) {
+    t_scoreHeader h;
+    h.magic = SCORE_MAGIC;
+    h.version = SCORE_VERSION;
+    h.sampleRate = 44100;
+    h.voiceCount = 1;
+    h.keyframeCount = keyframeCount;
+    h.voiceTableOffset = sizeof(t_scoreHeader);
+    h.keyframeOffset = h.voiceTableOffset + sizeof(t_scoreVoice);
+    t_scoreVoice voice = { 0, times.size() };
+
+    std::vector<uint64_t> image((h.keyframeOffset + times.size() * sizeof(t_scoreKeyframe)) / 8);
+    unsigned char *p = (unsigned char *) image.data();
+    memcpy(p, &h, sizeof(h));
+    memcpy(p + h.voiceTableOffset, &voice, sizeof(voice));
+    for (size_t i = 0; i < times.size(); i++) {
+        t_scoreKeyframe k = {};
+        k.sampleTime = times[i];
+        k.frequency = 140;
+        k.flags = SCORE_FREQUENCY;
+        memcpy(p + h.keyframeOffset + i * sizeof(k), &k, sizeof(k));
+    }
+    return image;
+}
+
+static t_renderStatus send(RenderClient &client, const std::vector<uint64_t> &image) {
+    t_renderOptions options;
+    options.tailSeconds = 0.05f;
+    RenderArchive archive;
+    return client.render(image.data(), image.size() * 8, options, archive);
+}
+
+int main() {
+    std::string path = "/tmp/pink-trombone-test-" + std::to_string(getpid()) + ".sock";
+    RenderDaemon daemon;
+    daemon.setThreadCount(1);
+    CHECK(daemon.start(path));
+
+    RenderClient client;
+    CHECK(client.connect(path));
+
+    // A keyframe count whose size wraps to 0, with a voice claiming three
+    // keyframes in a 56-byte image
+    std::vector<uint64_t> overflow = makeScore({}, 1ull << 61);
+    ((t_scoreVoice *) ((unsigned char *) overflow.data() + sizeof(t_scoreHeader)))->keyframeCount = 3;
+    CHECK(send(client, overflow) == RENDER_STATUS_BAD_SCORE);
+
+    // Voice reaching past the keyframes, and keyframes going back in time
+    CHECK(send(client, makeScore({ 0, 100 }, 1)) == RENDER_STATUS_BAD_SCORE);
+    CHECK(send(client, makeScore({ 0, 2000, 1000 }, 3)) == RENDER_STATUS_BAD_SCORE);
+
+    // The same connection, and a new one, still get renders
+    CHECK(daemon.isRunning());
+    CHECK(send(client, makeScore({ 0, 2000 }, 2)) == RENDER_STATUS_OK);
+    RenderClient second;
+    CHECK(second.connect(path));
+    CHECK(send(second, makeScore({ 0, 1000 }, 2)) == RENDER_STATUS_OK);
+
+    client.disconnect();
+    second.disconnect();
+    daemon.stop();
+    printf("render daemon: ok\n");
+    return 0;
+}
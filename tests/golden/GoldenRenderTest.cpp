@@ -0,0 +1,131 @@
+//==============================================================================
+// tests/golden/GoldenRenderTest.cpp
+// Renders fixed scripts on seeded voices at two host buffer sizes and
+// compares them bit for bit against the golden files in data/
+//==============================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "PinkTrombone.h"
+
+#define GOLDEN_SAMPLE_RATE  (44100.0f)
+#define GOLDEN_LENGTH       (16384)     // samples per script
+#define GOLDEN_SEED         (12345)
+
+// Setter calls at a fixed sample time, however the host splits its buffers
+struct Event {
+    int time;
+    void (*apply)(PinkTrombone &voice);
+};
+
+struct Script {
+    const char *name;
+    std::vector<Event> events;
+};
+
+static const std::vector<Script> scripts = {
+    { "vowels", {
+        { 0,     [](PinkTrombone &v) { v.setFrequency(120.0f); v.setTenseness(0.6f); } },
+        { 2000,  [](PinkTrombone &v) { v.setTonguePosition(27.0f, 2.0f); } },
+        { 6000,  [](PinkTrombone &v) { v.setFrequency(180.0f); v.setVibrato(0.02f, 5.0f); } },
+        { 9001,  [](PinkTrombone &v) { v.setTonguePosition(14.0f, 2.8f); v.setTenseness(0.9f); } },
+        { 13000, [](PinkTrombone &v) { v.setFrequency(90.0f); v.setTenseness(0.2f); } },
+    } },
+    { "consonants", {
+        { 0,     [](PinkTrombone &v) { v.setArticulation(ARTICULATION_A); } },
+        { 3000,  [](PinkTrombone &v) { v.setArticulation(ARTICULATION_S); v.setConstriction(37.0f, 0.4f, 1.0f); } },
+        { 6500,  [](PinkTrombone &v) { v.setConstriction(-1.0f, 3.0f, 0.0f); v.morphArticulation(ARTICULATION_M, ARTICULATION_I, 0.0f); } },
+        { 8000,  [](PinkTrombone &v) { v.morphArticulation(ARTICULATION_M, ARTICULATION_I, 1.0f); } },
+        { 11000, [](PinkTrombone &v) { v.setTonguePosition(12.9f, 2.43f); v.setConstriction(1, 41.0f, 0.0f, 0.0f); } },
+        { 12500, [](PinkTrombone &v) { v.setConstriction(1, -1.0f, 0.0f, 0.0f); } },
+    } },
+    { "formant", {
+        { 0,     [](PinkTrombone &v) { v.setEngine(VOICE_ENGINE_FORMANT); v.setMathQuality(MATH_QUALITY_FAST); } },
+        { 4000,  [](PinkTrombone &v) { v.setTonguePosition(25.0f, 2.05f); v.setFrequency(200.0f); } },
+        { 8000,  [](PinkTrombone &v) { v.setConstriction(34.0f, 0.5f, 0.8f); } },
+        { 12000, [](PinkTrombone &v) { v.setEngine(VOICE_ENGINE_WAVEGUIDE); v.setConstriction(-1.0f, 3.0f, 0.0f); } },
+    } },
+};
+
+// Renders the script in host buffers of bufferSize, cut short where an event falls
+static std::vector<float> render(const Script &script, int bufferSize) {
+    PinkTrombone voice(GOLDEN_SAMPLE_RATE);
+    voice.setSeed(GOLDEN_SEED);
+    std::vector<float> output(GOLDEN_LENGTH);
+    size_t next = 0;
+    int time = 0;
+    while (time < GOLDEN_LENGTH) {
+        while (next < script.events.size() && script.events[next].time <= time) {
+            script.events[next++].apply(voice);
+        }
+        int end = std::min(time + bufferSize, GOLDEN_LENGTH);
+        if (next < script.events.size()) end = std::min(end, script.events[next].time);
+        voice.synthesize(&output[time], end - time);
+        time = end;
+    }
+    return output;
+}
+
+static bool readGolden(const std::string &path, std::vector<float> &samples) {
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    samples.resize(GOLDEN_LENGTH);
+    size_t count = fread(samples.data(), sizeof(float), samples.size() + 1, file);
+    fclose(file);
+    return count == samples.size();
+}
+
+static bool writeGolden(const std::string &path, const std::vector<float> &samples) {
+    FILE *file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    size_t count = fwrite(samples.data(), sizeof(float), samples.size(), file);
+    return fclose(file) == 0 && count == samples.size();
+}
+
+// Usage: golden_render <data directory> [--update]
+// With --update the golden files are rewritten from a 512-sample render, after
+// a change that is meant to alter the sound.
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <data directory> [--update]\n", argv[0]);
+        return 2;
+    }
+    std::string directory = argv[1];
+    bool update = argc > 2 && strcmp(argv[2], "--update") == 0;
+    const int bufferSizes[] = { 512, 37 };
+
+    int failures = 0;
+    for (const Script &script : scripts) {
+        std::string path = directory + "/" + script.name + ".f32";
+        std::vector<float> golden;
+        if (update) {
+            golden = render(script, bufferSizes[0]);
+            if (!writeGolden(path, golden)) {
+                fprintf(stderr, "%s: could not write\n", path.c_str());
+                return 2;
+            }
+            printf("%s: updated\n", path.c_str());
+            continue;
+        }
+        if (!readGolden(path, golden)) {
+            fprintf(stderr, "%s: missing or not %d samples\n", path.c_str(), GOLDEN_LENGTH);
+            failures++;
+            continue;
+        }
+        for (int bufferSize : bufferSizes) {
+            std::vector<float> output = render(script, bufferSize);
+            int i = 0;
+            while (i < GOLDEN_LENGTH && memcmp(&output[i], &golden[i], sizeof(float)) == 0) i++;
+            if (i < GOLDEN_LENGTH) {
+                fprintf(stderr, "%s, %d-sample buffers: sample %d is %.9g, golden %.9g\n",
+                        script.name, bufferSize, i, output[i], golden[i]);
+                failures++;
+            } else {
+                printf("%s, %d-sample buffers: ok\n", script.name, bufferSize);
+            }
+        }
+    }
+    return failures > 0 ? 1 : 0;
+}
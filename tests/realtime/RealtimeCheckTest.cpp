@@ -0,0 +1,75 @@
+//==============================================================================
+// tests/realtime/RealtimeCheckTest.cpp
+// Renders a voice under the realtime checker: a clean render must not report
+// anything, and an allocation inside the audio-thread scope must be caught
+//==============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "PinkTrombone.h"
+#include "VoicePool.h"
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            return 1; \
+        } \
+    } while (0)
+
+// Keeps the compiler from eliding the malloc/free pair below
+static void* volatile sink;
+
+int main() {
+    PinkTrombone voice(44100.0f);
+    voice.setSeed(1);
+    float buffer[512 * 2];
+
+    // Exercise the setters, the multi-channel path and the formant engine
+    // between buffers, as a host would from its control thread
+    RealtimeCheck::resetViolationCount();
+    for (int i = 0; i < 200; i++) {
+        voice.setFrequency(100.0f + i);
+        voice.setTonguePosition(12.0f + (i % 20), 2.0f + 0.05f * (i % 20));
+        voice.setConstriction(36.0f, i % 50 < 25 ? 0.3f : 3.0f, 0.5f);
+        if (i == 100) voice.setEngine(VOICE_ENGINE_FORMANT);
+        if (i % 2) voice.synthesize(buffer, 512);
+        else voice.synthesize(buffer, 512, 2);
+    }
+    CHECK(RealtimeCheck::getViolationCount() == 0);
+
+    // Pooled voices can be spawned, rendered and released on the audio thread
+    VoicePool pool(2);
+    {
+        RealtimeCheck::Scope scope;
+        PinkTrombone* pooled = pool.createVoice(44100.0f);
+        CHECK(pooled != nullptr);
+        pooled->setArticulation(ARTICULATION_I);
+        pooled->synthesize(buffer, 512);
+        pool.destroyVoice(pooled);
+    }
+    CHECK(RealtimeCheck::getViolationCount() == 0);
+
+    // The same scope synthesize() marks the audio thread with
+    {
+        RealtimeCheck::Scope scope;
+        sink = malloc(64);
+        free(sink);
+    }
+    CHECK(RealtimeCheck::getViolationCount() > 0);
+
+    // Outside the scope, and inside an Allow, allocation is fine
+    RealtimeCheck::resetViolationCount();
+    sink = malloc(64);
+    free(sink);
+    {
+        RealtimeCheck::Scope scope;
+        RealtimeCheck::Allow allow;
+        sink = malloc(64);
+        free(sink);
+    }
+    CHECK(RealtimeCheck::getViolationCount() == 0);
+
+    printf("realtime check: ok\n");
+    return 0;
+}
@@ -0,0 +1,93 @@
+//==============================================================================
+// tests/score/ScoreLoadTest.cpp
+// Score::load() on a well-formed image and on headers and tables that lie
+// about the data, which must all be rejected
+//==============================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "Score.h"
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            return 1; \
+        } \
+    } while (0)
+
+// Score image in 8-byte aligned storage, laid out as Score::write() does
+struct Image {
+    std::vector<uint64_t> storage;
+
+    Image(const std::vector<t_scoreVoice> &voices, const std::vector<t_scoreKeyframe> &keyframes) {
+        t_scoreHeader h;
+        h.magic = SCORE_MAGIC;
+        h.version = SCORE_VERSION;
+        h.sampleRate = 44100;
+        h.voiceCount = (uint32_t) voices.size();
+        h.keyframeCount = keyframes.size();
+        h.voiceTableOffset = sizeof(t_scoreHeader);
+        h.keyframeOffset = h.voiceTableOffset + voices.size() * sizeof(t_scoreVoice);
+        size_t size = h.keyframeOffset + keyframes.size() * sizeof(t_scoreKeyframe);
+        storage.resize(size / sizeof(uint64_t));
+        unsigned char *p = bytes();
+        memcpy(p, &h, sizeof(h));
+        if (!voices.empty()) memcpy(p + h.voiceTableOffset, voices.data(), voices.size() * sizeof(t_scoreVoice));
+        if (!keyframes.empty()) memcpy(p + h.keyframeOffset, keyframes.data(), keyframes.size() * sizeof(t_scoreKeyframe));
+    }
+
+    unsigned char *bytes() { return (unsigned char *) storage.data(); }
+    size_t size() const { return storage.size() * sizeof(uint64_t); }
+    t_scoreHeader &header() { return *(t_scoreHeader *) bytes(); }
+};
+
+static t_scoreKeyframe keyframe(uint64_t sampleTime) {
+    t_scoreKeyframe k = {};
+    k.sampleTime = sampleTime;
+    k.frequency = 140;
+    k.flags = SCORE_FREQUENCY;
+    return k;
+}
+
+int main() {
+    Score score;
+
+    // Two voices of two keyframes each
+    Image valid({ { 0, 2 }, { 2, 2 } }, { keyframe(0), keyframe(100), keyframe(50), keyframe(300) });
+    CHECK(score.load(valid.bytes(), valid.size()));
+    CHECK(score.getVoiceCount() == 2);
+    CHECK(score.getLength() == 300);
+
+    // A keyframe count whose size in bytes wraps to 0, with a voice that
+    // would then reach far past the 56 bytes of data
+    Image overflow({ { 0, 3 } }, {});
+    overflow.header().keyframeCount = 1ull << 61;
+    CHECK(!score.load(overflow.bytes(), overflow.size()));
+    CHECK(!score.isLoaded());
+
+    // Keyframe count larger than the data
+    Image truncated({ { 0, 1 } }, { keyframe(0) });
+    truncated.header().keyframeCount = 2;
+    CHECK(!score.load(truncated.bytes(), truncated.size()));
+
+    // Voice reaching past the keyframe array, and one whose range wraps
+    Image outOfRange({ { 1, 2 } }, { keyframe(0), keyframe(10) });
+    CHECK(!score.load(outOfRange.bytes(), outOfRange.size()));
+    Image wrapping({ { 1, ~0ull } }, { keyframe(0), keyframe(10) });
+    CHECK(!score.load(wrapping.bytes(), wrapping.size()));
+
+    // Keyframes going back in time within a voice; across voices is fine
+    Image unsorted({ { 0, 3 } }, { keyframe(0), keyframe(200), keyframe(100) });
+    CHECK(!score.load(unsorted.bytes(), unsorted.size()));
+
+    // Bad magic, and a header cut short
+    Image magic({ { 0, 1 } }, { keyframe(0) });
+    magic.header().magic = 0;
+    CHECK(!score.load(magic.bytes(), magic.size()));
+    CHECK(!score.load(valid.bytes(), sizeof(t_scoreHeader) - 8));
+
+    printf("score load: ok\n");
+    return 0;
+}
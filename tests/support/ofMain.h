@@ -0,0 +1,20 @@
+//==============================================================================
+// tests/support/ofMain.h
+// Stand-in for openFrameworks' ofMain.h, so the tests build the voice without
+// the framework: only what PinkTrombone and the core use from it
+//==============================================================================
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+inline float ofClamp(float value, float min, float max) {
+    return value < min ? min : (value > max ? max : value);
+}